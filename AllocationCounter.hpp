@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// ============================================================================
+// ALLOCATION COUNTING
+// ============================================================================
+
+// Replaces the global allocation functions so that every heap allocation of
+// the program is counted, and tests and benchmarks can check allocations per
+// document and bytes per entry. Include it from exactly one translation unit
+// of a program, as the replacements must be defined once.
+std::atomic<uint64_t> heapAllocations{0};
+std::atomic<uint64_t> heapBytes{0};
+
+void *operator new(size_t size)
+{
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    heapBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+// GCC inlines these into callers and then sees free() release memory from
+// operator new, which is right here since operator new is malloc().
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// Over-aligned types (alignas beyond the default new alignment) come through
+// these, so they are counted too.
+static void *alignedAllocate(size_t size, std::align_val_t alignment)
+{
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    heapBytes.fetch_add(size, std::memory_order_relaxed);
+    const size_t align = static_cast<size_t>(alignment);
+#if defined(_WIN32)
+    if (void *p = _aligned_malloc(size ? size : 1, align))
+        return p;
+#else
+    if (void *p = std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) / align * align))
+        return p;
+#endif
+    throw std::bad_alloc();
+}
+
+static void alignedFree(void *p) noexcept
+{
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+    return alignedAllocate(size, alignment);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+    return alignedAllocate(size, alignment);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+    alignedFree(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept
+{
+    alignedFree(p);
+}
+
+void operator delete(void *p, size_t, std::align_val_t) noexcept
+{
+    alignedFree(p);
+}
+
+void operator delete[](void *p, size_t, std::align_val_t) noexcept
+{
+    alignedFree(p);
+}
@@ -0,0 +1,1381 @@
+#include "PhoneDetector.hpp"
+#include "AllocationCounter.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+
+// ============================================================================
+// PhoneBenchmark - reproducible benchmark suite
+//
+//   PhoneBenchmark [--scenario NAME]... [--seed N] [--rounds N] [--quick]
+//                  [--docs N] [--size MIN[:MAX]] [--density D] [--adversarial F]
+//                  [--mix type=weight,...] [--json FILE|-] [--list] [--linearity]
+//
+// Every corpus comes from a seeded generator, so two runs with the same seed
+// scan identical bytes. Results go to stdout as a table and, with --json, to a
+// file that can be diffed between builds. The feature scenarios (incremental
+// edits, calling codes, custom formats, the result cache, the arena) run their
+// own seeded workloads into the same tables. --linearity instead times
+// pathological inputs at growing sizes and fails if the cost per byte grows.
+// ============================================================================
+
+// ============================================================================
+// CORPUS GENERATOR
+// ============================================================================
+
+// Formats the generator can plant, in PhoneType order.
+constexpr PhoneType GENERATED_TYPES[] = {
+    PhoneType::FORMATTED_DOMESTIC, PhoneType::FORMATTED_TOLL_FREE, PhoneType::INTERNATIONAL_PLUS, PhoneType::INTERNATIONAL_00,
+    PhoneType::PLAIN_10_DIGIT, PhoneType::PLAIN_11_DIGIT, PhoneType::MOBILE_10_DIGIT};
+constexpr size_t GENERATED_TYPE_COUNT = sizeof(GENERATED_TYPES) / sizeof(GENERATED_TYPES[0]);
+const char *const MIX_NAMES[GENERATED_TYPE_COUNT] = {"domestic", "tollfree", "intl", "intl00", "plain10", "plain11", "mobile"};
+
+struct CorpusSpec
+{
+    std::string name;
+    size_t documents = 1000;
+    size_t minSize = 1000;
+    size_t maxSize = 1000;
+    double density = 1.0;     // planted numbers per KB
+    double adversarial = 0.0; // fraction of filler tokens replaced by near-misses
+    double mix[GENERATED_TYPE_COUNT] = {1, 1, 1, 1, 1, 1, 1};
+};
+
+class CorpusGenerator
+{
+private:
+    std::mt19937_64 rng;
+    const CorpusSpec &spec;
+
+    static constexpr double AVERAGE_TOKEN_BYTES = 7.0;
+
+    char digit() { return static_cast<char>('0' + rng() % 10); }
+    char leading() { return static_cast<char>('2' + rng() % 8); } // NANP "N": 2-9
+    bool chance(double p) { return std::uniform_real_distribution<double>(0.0, 1.0)(rng) < p; }
+
+    // Fills a pattern: N -> 2-9, X -> 0-9, anything else is copied.
+    std::string fill(const char *pattern)
+    {
+        std::string out;
+        for (const char *p = pattern; *p; ++p)
+            out += *p == 'N' ? leading() : *p == 'X' ? digit() : *p;
+        return out;
+    }
+
+    template <size_t N>
+    const char *pick(const char *const (&choices)[N]) { return choices[rng() % N]; }
+
+    std::string number(PhoneType type)
+    {
+        switch (type)
+        {
+        case PhoneType::FORMATTED_DOMESTIC:
+            return fill(pick({"(NXX) NXX-XXXX", "NXX-NXX-XXXX", "NXX.NXX.XXXX", "(NXX)-NXX-XXXX"}));
+        case PhoneType::FORMATTED_TOLL_FREE:
+            return fill(pick({"1-800-NXX-XXXX", "1-888-NXX-XXXX", "1.877.NXX.XXXX", "1-866-NXX-XXXX"}));
+        case PhoneType::INTERNATIONAL_PLUS:
+            return fill(pick({"+1 (NXX) NXX-XXXX", "+91-9XXXXXXXXX", "+44 20 XXXX XXXX", "+49 30 XXXXXXX", "+33 X XX XX XX XX"}));
+        case PhoneType::INTERNATIONAL_00:
+            return fill(pick({"00 1 NXX-NXX-XXXX", "0091 9XXXXXXXXX", "0044 20 XXXX XXXX", "00 49 30 XXXXXXX", "0033 X XX XX XX XX"}));
+        case PhoneType::PLAIN_10_DIGIT:
+            return fill("NXXNXXXXXX");
+        case PhoneType::PLAIN_11_DIGIT:
+            return fill("1NXXNXXXXXX");
+        case PhoneType::MOBILE_10_DIGIT:
+            return fill(pick({"9XXXX XXXXX", "8XXXX XXXXX", "7XXXX XXXXX"}));
+        default:
+            return fill("NXXNXXXXXX");
+        }
+    }
+
+    // Digit-heavy tokens that look like numbers but must not match, or only
+    // barely. They exercise rejection paths rather than the prefilter.
+    std::string nearMiss()
+    {
+        switch (rng() % 10)
+        {
+        case 0:
+            return fill("XXXXXXXX");
+        case 1:
+            return fill("XXXXXXXXXXXXXXX");
+        case 2:
+            return fill("(NXX) NXX-XXX");
+        case 3:
+            return fill("NXX-XX-XXXX");
+        case 4:
+            return fill("+X X");
+        case 5:
+            return fill("X-X-X-X-X-X-X-X-X-X-X-X");
+        case 6:
+            return std::string(8 + rng() % 8, rng() % 2 ? '(' : '+');
+        case 7:
+            return fill("X X X X X X X X X");
+        case 8:
+            return fill("NXX.NXX.XXXXX");
+        default:
+            return fill("X  X - X . X");
+        }
+    }
+
+    std::string filler()
+    {
+        static const char *const words[] = {
+            "the", "order", "was", "shipped", "to", "customer", "please", "call", "back", "at", "or", "email",
+            "support", "ticket", "status", "updated", "INFO", "WARN", "request", "handled", "user", "id", "ref",
+            "thanks", "regards", "meeting", "tomorrow", "invoice", "payment", "received", "account", "notes"};
+        static const char *const numeric[] = {"2024-06-11", "12:30:45", "#48213", "$12.50", "10.0.0.1", "v2.3.1",
+                                              "42", "7", "2024", "ZIP 94103", "x1024", "3.14159"};
+        if (rng() % 8 == 0)
+            return pick(numeric);
+        return pick(words);
+    }
+
+    PhoneType pickType()
+    {
+        double total = 0;
+        for (double weight : spec.mix)
+            total += weight;
+        double r = std::uniform_real_distribution<double>(0.0, total)(rng);
+        for (size_t t = 0; t < GENERATED_TYPE_COUNT; ++t)
+        {
+            if (r < spec.mix[t])
+                return GENERATED_TYPES[t];
+            r -= spec.mix[t];
+        }
+        return GENERATED_TYPES[GENERATED_TYPE_COUNT - 1];
+    }
+
+public:
+    CorpusGenerator(const CorpusSpec &corpus, uint64_t seed) : rng(seed), spec(corpus) {}
+
+    std::string document()
+    {
+        const size_t target = spec.minSize + (spec.maxSize > spec.minSize ? rng() % (spec.maxSize - spec.minSize + 1) : 0);
+        const double numberChance = std::min(1.0, spec.density * AVERAGE_TOKEN_BYTES / 1024.0);
+        std::string doc;
+        doc.reserve(target + 32);
+        while (doc.size() < target)
+        {
+            if (chance(numberChance))
+                doc += number(pickType());
+            else if (chance(spec.adversarial))
+                doc += nearMiss();
+            else
+                doc += filler();
+            doc += rng() % 16 == 0 ? '\n' : ' ';
+        }
+        doc.resize(target);
+        return doc;
+    }
+
+    std::vector<std::string> corpus()
+    {
+        std::vector<std::string> docs;
+        docs.reserve(spec.documents);
+        for (size_t d = 0; d < spec.documents; ++d)
+            docs.push_back(document());
+        return docs;
+    }
+};
+
+std::vector<CorpusSpec> builtinScenarios(bool quick)
+{
+    const size_t scale = quick ? 10 : 1;
+    std::vector<CorpusSpec> scenarios(6);
+
+    scenarios[0].name = "sms";
+    scenarios[0].documents = 20000 / scale;
+    scenarios[0].minSize = 100;
+    scenarios[0].maxSize = 200;
+    scenarios[0].density = 4.0;
+
+    scenarios[1].name = "chat";
+    scenarios[1].documents = 5000 / scale;
+    scenarios[1].minSize = 500;
+    scenarios[1].maxSize = 2000;
+    scenarios[1].density = 2.0;
+
+    scenarios[2].name = "logs";
+    scenarios[2].documents = 200 / scale;
+    scenarios[2].minSize = 32 * 1024;
+    scenarios[2].maxSize = 128 * 1024;
+    scenarios[2].density = 1.0;
+
+    scenarios[3].name = "sparse";
+    scenarios[3].documents = 20 / std::min<size_t>(scale, 4);
+    scenarios[3].minSize = scenarios[3].maxSize = 1024 * 1024;
+    scenarios[3].density = 0.0;
+
+    scenarios[4].name = "adversarial";
+    scenarios[4].documents = 100 / scale;
+    scenarios[4].minSize = 16 * 1024;
+    scenarios[4].maxSize = 64 * 1024;
+    scenarios[4].density = 1.0;
+    scenarios[4].adversarial = 0.5;
+
+    scenarios[5].name = "large";
+    scenarios[5].documents = 1;
+    scenarios[5].minSize = scenarios[5].maxSize = (quick ? 16 : 100) * 1024 * 1024;
+    scenarios[5].density = 1.0;
+    return scenarios;
+}
+
+// ============================================================================
+// MEASUREMENT
+// ============================================================================
+
+struct EngineResult
+{
+    std::string engine;
+    double bytesPerSecond = 0;
+    double docsPerSecond = 0;
+    double matchesPerSecond = 0;
+    double allocationsPerDoc = 0;
+    size_t matches = 0; // per round
+    bool hasLatency = false;
+    double p50 = 0, p99 = 0, p999 = 0; // ns per document
+    std::vector<std::pair<std::string, double>> metrics; // figures particular to one engine, e.g. hit rate
+};
+
+struct ScenarioResult
+{
+    CorpusSpec spec;
+    std::string description; // set by the feature scenarios, whose corpora are not one CorpusSpec
+    size_t bytes = 0;
+    size_t customDocuments = 0; // where builtin() and PhoneScanner find as many matches
+    std::vector<EngineResult> engines;
+};
+
+double percentile(std::vector<double> &samples, double fraction)
+{
+    if (samples.empty())
+        return 0;
+    const size_t rank = std::min(samples.size() - 1, static_cast<size_t>(fraction * static_cast<double>(samples.size())));
+    std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+    return samples[rank];
+}
+
+class Bench
+{
+private:
+    const std::vector<std::string> &docs;
+    size_t bytes;
+    int rounds;
+
+    EngineResult finish(const std::string &engine, double seconds, size_t matches, uint64_t allocations) const
+    {
+        const double docCount = static_cast<double>(docs.size()) * rounds;
+        EngineResult result;
+        result.engine = engine;
+        result.bytesPerSecond = static_cast<double>(bytes) * rounds / seconds;
+        result.docsPerSecond = docCount / seconds;
+        result.matchesPerSecond = static_cast<double>(matches) / seconds;
+        result.allocationsPerDoc = static_cast<double>(allocations) / docCount;
+        result.matches = matches / static_cast<size_t>(rounds);
+        return result;
+    }
+
+public:
+    Bench(const std::vector<std::string> &corpus, size_t totalBytes, int roundCount)
+        : docs(corpus), bytes(totalBytes), rounds(roundCount) {}
+
+    // Times fn(doc) -> match count per document, after one warm-up round.
+    template <typename Fn>
+    EngineResult perDocument(const std::string &engine, Fn &&fn) const
+    {
+        for (const auto &doc : docs)
+            fn(doc);
+
+        std::vector<double> latencies;
+        latencies.reserve(docs.size() * rounds);
+        size_t matches = 0;
+        double seconds = 0;
+        const uint64_t before = heapAllocations.load();
+        for (int r = 0; r < rounds; ++r)
+        {
+            for (const auto &doc : docs)
+            {
+                auto start = std::chrono::steady_clock::now();
+                matches += fn(doc);
+                const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                seconds += elapsed;
+                latencies.push_back(elapsed * 1e9);
+            }
+        }
+        // The latency vector was reserved up front, so it does not count here.
+        const uint64_t allocations = heapAllocations.load() - before;
+
+        EngineResult result = finish(engine, seconds, matches, allocations);
+        result.hasLatency = true;
+        result.p50 = percentile(latencies, 0.50);
+        result.p99 = percentile(latencies, 0.99);
+        result.p999 = percentile(latencies, 0.999);
+        return result;
+    }
+
+    // Times fn() -> match count for the whole corpus at once (no per-document latency).
+    template <typename Fn>
+    EngineResult wholeCorpus(const std::string &engine, Fn &&fn) const
+    {
+        fn();
+        size_t matches = 0;
+        const uint64_t before = heapAllocations.load();
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r)
+            matches += fn();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return finish(engine, seconds, matches, heapAllocations.load() - before);
+    }
+};
+
+// For work that is not one call per document of a corpus (edits, lookups,
+// batches): `events` of them took `seconds` and found `matches` over `rounds`.
+EngineResult timedEvents(const std::string &engine, double seconds, size_t events, double bytes, size_t matches,
+                         uint64_t allocations, std::vector<double> latencies = {}, size_t rounds = 1)
+{
+    EngineResult result;
+    result.engine = engine;
+    result.bytesPerSecond = bytes / seconds;
+    result.docsPerSecond = static_cast<double>(events) / seconds;
+    result.matchesPerSecond = static_cast<double>(matches) / seconds;
+    result.allocationsPerDoc = static_cast<double>(allocations) / static_cast<double>(events);
+    result.matches = matches / rounds;
+    if (!latencies.empty())
+    {
+        result.hasLatency = true;
+        result.p50 = percentile(latencies, 0.50);
+        result.p99 = percentile(latencies, 0.99);
+        result.p999 = percentile(latencies, 0.999);
+    }
+    return result;
+}
+
+double nanosSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <PhoneType Type>
+void measureFormat(const Bench &bench, std::vector<EngineResult> &out)
+{
+    const PhoneScannerFor<Type> scanner;
+    out.push_back(bench.perDocument(std::string("format.") + phoneTypeToString(Type), [&](const std::string &doc)
+                                    { return scanner.count(doc); }));
+}
+
+ScenarioResult runScenario(const CorpusSpec &spec, uint64_t seed, int rounds)
+{
+    ScenarioResult scenario;
+    scenario.spec = spec;
+
+    CorpusGenerator generator(spec, seed);
+    const std::vector<std::string> docs = generator.corpus();
+    size_t largest = 0;
+    for (const auto &doc : docs)
+    {
+        scenario.bytes += doc.size();
+        largest = std::max(largest, doc.size());
+    }
+
+    const PhoneScanner scanner;
+    const Bench bench(docs, scenario.bytes, rounds);
+    auto &out = scenario.engines;
+    std::vector<std::string_view> views(docs.begin(), docs.end());
+    PhoneMatchBatch batch;
+    PhoneMatchColumns columns;
+
+    out.push_back(bench.perDocument("stream.feed", [&](const std::string &doc)
+                                    {
+        StreamingPhoneScanner stream;
+        return stream.feed(doc).size() + stream.finish().size(); }));
+    out.push_back(bench.perDocument("redact.inplace", [&](const std::string &doc)
+                                    {
+        std::string copy = doc; // included in the timing; compare with redact.writer
+        return scanner.redactInPlace(copy.data(), copy.size()); }));
+    out.push_back(bench.perDocument("redact.writer", [&](const std::string &doc)
+                                    {
+        size_t written = 0;
+        const size_t found = scanner.redact(doc, [&](std::string_view piece)
+                                            { written += piece.size(); });
+        return written == doc.size() ? found : 0; }));
+    // The built-in formats as runtime patterns, compiled once. builtin() has
+    // neither the calling-code table nor the overlap rules, so it is timed
+    // only on the documents where it finds as many matches as PhoneScanner,
+    // next to PhoneScanner on the same documents.
+    const CustomPhoneScanner custom(PhoneFormatSet::builtin());
+    auto reference = [&](const std::string &doc)
+    {
+        if (doc.size() <= PhoneScanner::maxInputSize())
+            return scanner.count(doc);
+        StreamingPhoneScanner stream;
+        return stream.feed(doc).size() + stream.finish().size();
+    };
+    std::vector<std::string> agreeing;
+    size_t agreeingBytes = 0;
+    for (const auto &doc : docs)
+        if (custom.count(doc) == reference(doc))
+        {
+            agreeing.push_back(doc);
+            agreeingBytes += doc.size();
+        }
+    scenario.customDocuments = agreeing.size();
+    if (!agreeing.empty())
+    {
+        const Bench agreed(agreeing, agreeingBytes, rounds);
+        out.push_back(agreed.perDocument("custom.count", [&](const std::string &doc)
+                                         { return custom.count(doc); }));
+        out.push_back(agreed.perDocument("custom.reference", reference));
+    }
+
+    // The one-shot engines return nothing past their input limit.
+    if (largest > PhoneScanner::maxInputSize())
+        return scenario;
+
+    out.push_back(bench.perDocument("fused.extract", [&](const std::string &doc)
+                                    { return scanner.extract(doc).size(); }));
+    out.push_back(bench.perDocument("fused.extractViews", [&](const std::string &doc)
+                                    { return scanner.extractViews(doc).size(); }));
+    // A deadline nothing reaches: the cost of the checks alone.
+    const ScanOptions farDeadline = ScanOptions::within(std::chrono::hours(1));
+    out.push_back(bench.perDocument("fused.extractViews+deadline", [&](const std::string &doc)
+                                    { return scanner.extractViews(doc, farDeadline).matches.size(); }));
+    out.push_back(bench.perDocument("fused.extractViews+options", [&](const std::string &doc)
+                                    { return scanner.extractViews(doc, ScanOptions{}).matches.size(); }));
+    ScanOptions farLimits = farDeadline;
+    farLimits.maxMatches = SIZE_MAX / 2;
+    farLimits.maxBytes = SIZE_MAX / 2;
+    out.push_back(bench.perDocument("fused.extractViews+limits", [&](const std::string &doc)
+                                    { return scanner.extractViews(doc, farLimits).matches.size(); }));
+    out.push_back(bench.perDocument("fused.count", [&](const std::string &doc)
+                                    { return scanner.count(doc); }));
+    out.push_back(bench.wholeCorpus("fused.extractBatch", [&]()
+                                    {
+        scanner.extractBatch(views.data(), views.size(), batch);
+        return batch.matches.size(); }));
+    out.push_back(bench.wholeCorpus("fused.extractColumns", [&]()
+                                    {
+        scanner.extractColumns(views.data(), views.size(), columns);
+        return columns.size(); }));
+    const size_t columnBytes = columns.size() * (4 + 4 + 1 + 1 + 4) + columns.digits.size();
+    out.back().metrics.emplace_back("bytes_per_match", columns.size() ? static_cast<double>(columnBytes) / columns.size() : 0.0);
+    // What an exporter does without extractColumns(): extract(), then copy.
+    PhoneMatchColumns converted;
+    out.push_back(bench.wholeCorpus("fused.extract+columns", [&]()
+                                    {
+        converted.clear();
+        for (size_t d = 0; d < docs.size(); ++d)
+            for (const auto &match : scanner.extract(docs[d]))
+            {
+                converted.document.push_back(static_cast<uint32_t>(d));
+                converted.position.push_back(static_cast<uint32_t>(match.position));
+                converted.length.push_back(static_cast<uint8_t>(match.value.size()));
+                converted.type.push_back(static_cast<uint8_t>(match.type));
+                converted.digits.insert(converted.digits.end(), match.normalized.begin(), match.normalized.end());
+                converted.digitOffsets.push_back(static_cast<int32_t>(converted.digits.size()));
+            }
+        return converted.size(); }));
+    out.push_back(bench.perDocument("multipass.extract", [&](const std::string &doc)
+                                    { return scanner.extractMultiPass(doc).size(); }));
+    out.push_back(bench.perDocument("pass.international", [&](const std::string &doc)
+                                    { return scanner.extractPass(doc, ScanPass::INTERNATIONAL).size(); }));
+    out.push_back(bench.perDocument("pass.formatted", [&](const std::string &doc)
+                                    { return scanner.extractPass(doc, ScanPass::FORMATTED).size(); }));
+    out.push_back(bench.perDocument("pass.plain", [&](const std::string &doc)
+                                    { return scanner.extractPass(doc, ScanPass::PLAIN).size(); }));
+
+    measureFormat<PhoneType::FORMATTED_DOMESTIC>(bench, out);
+    measureFormat<PhoneType::FORMATTED_TOLL_FREE>(bench, out);
+    measureFormat<PhoneType::INTERNATIONAL_PLUS>(bench, out);
+    measureFormat<PhoneType::INTERNATIONAL_00>(bench, out);
+    measureFormat<PhoneType::PLAIN_10_DIGIT>(bench, out);
+    measureFormat<PhoneType::PLAIN_11_DIGIT>(bench, out);
+    measureFormat<PhoneType::MOBILE_10_DIGIT>(bench, out);
+    return scenario;
+}
+
+// ============================================================================
+// FEATURE SCENARIOS
+// ============================================================================
+
+// Engines that need their own workload rather than a generated corpus: edits,
+// repeated messages, threads. They report through the same tables and JSON.
+
+ScenarioResult runIncrementalScenario(uint64_t seed, int rounds, bool quick)
+{
+    ScenarioResult scenario;
+    scenario.spec.documents = 0;
+    scenario.spec.density = 2.0;
+    std::vector<size_t> sizes = {100 * 1000, 1000 * 1000, 8 * 1000 * 1000};
+    if (quick)
+        sizes.pop_back();
+    scenario.spec.minSize = sizes.front();
+    scenario.spec.maxSize = sizes.back();
+
+    const PhoneScanner scanner;
+    std::mt19937_64 rng(seed);
+    for (size_t size : sizes)
+    {
+        CorpusSpec spec = scenario.spec;
+        spec.minSize = spec.maxSize = size;
+        std::string text = CorpusGenerator(spec, seed + size).document();
+        scenario.bytes += text.size();
+        ++scenario.spec.documents;
+        IncrementalPhoneScanner incremental(text);
+        const std::string suffix = "@" + std::to_string(size / 1000) + "K";
+
+        std::vector<double> latencies;
+        double seconds = 0;
+        size_t found = 0;
+        const int scans = 5 * rounds;
+        uint64_t allocations = heapAllocations.load();
+        for (int s = 0; s < scans; ++s)
+        {
+            auto start = std::chrono::steady_clock::now();
+            found += scanner.extractViews(text).size();
+            latencies.push_back(nanosSince(start));
+            seconds += latencies.back() / 1e9;
+        }
+        allocations = heapAllocations.load() - allocations;
+        scenario.engines.push_back(timedEvents("full.extractViews" + suffix, seconds, scans,
+                                               static_cast<double>(text.size()) * scans, found, allocations,
+                                               std::move(latencies), scans));
+        scenario.engines.back().metrics = {{"checkpoints", static_cast<double>(incremental.checkpointCount())},
+                                           {"chunks", static_cast<double>(incremental.chunkCount())},
+                                           {"depth", static_cast<double>(incremental.chunkDepth())}};
+
+        // One character per edit. Typing: bursts of 20 at a random place;
+        // scattered: every edit somewhere else.
+        const size_t edits = size > 1000 * 1000 ? 200 : 2000;
+        for (size_t burst : {20, 1})
+        {
+            latencies.clear();
+            seconds = 0;
+            allocations = 0;
+            size_t scanned = 0, cursor = 0;
+            for (size_t e = 0; e < edits; ++e)
+            {
+                cursor = e % burst ? cursor + 1 : rng() % text.size();
+                text.insert(text.begin() + static_cast<std::ptrdiff_t>(cursor), "0123456789 -("[rng() % 13]);
+                const uint64_t before = heapAllocations.load();
+                auto start = std::chrono::steady_clock::now();
+                scanned += incremental.insert(text, cursor, 1).scannedBytes;
+                latencies.push_back(nanosSince(start));
+                seconds += latencies.back() / 1e9;
+                allocations += heapAllocations.load() - before;
+            }
+            scenario.engines.push_back(timedEvents(std::string(burst > 1 ? "incremental.typing" : "incremental.scattered") + suffix,
+                                                   seconds, edits, static_cast<double>(text.size()) * edits,
+                                                   incremental.size() * edits, allocations, std::move(latencies), edits));
+            scenario.engines.back().metrics = {{"rescanned_bytes_per_edit", static_cast<double>(scanned) / edits}};
+        }
+    }
+    return scenario;
+}
+
+ScenarioResult runCallingCodeScenario(uint64_t seed, int rounds, bool quick)
+{
+    ScenarioResult scenario;
+    const size_t size = (quick ? 1 : 4) * 1024 * 1024;
+
+    // Planted numbers use real codes at a valid length; decoys are the IDs and
+    // stamps that pass a "'+' and 7-15 digits" rule, plus zero-padded IDs that
+    // reach the "00" check.
+    std::mt19937_64 rng(seed);
+    auto digits = [&](size_t n, char first)
+    {
+        std::string out(1, first);
+        while (out.size() < n)
+            out += static_cast<char>('0' + rng() % 10);
+        return out;
+    };
+    const char *const words[] = {"order", "shipped", "ref", "call", "ticket", "at", "status", "id", "invoice", "ok"};
+    const size_t assignmentCount = sizeof(CALLING_CODE_ASSIGNMENTS) / sizeof(CALLING_CODE_ASSIGNMENTS[0]);
+
+    std::string text;
+    std::vector<size_t> planted, decoys;
+    while (text.size() < size)
+    {
+        text += words[rng() % 10];
+        text += ' ';
+        const unsigned kind = rng() % 10;
+        if (kind < 2)
+        {
+            const CallingCodeAssignment &a = CALLING_CODE_ASSIGNMENTS[rng() % assignmentCount];
+            const std::string code = std::to_string(a.code);
+            const size_t national = std::max<size_t>(a.minNational + rng() % (a.maxNational - a.minNational + 1), 7 - code.size());
+            if (national > a.maxNational)
+                continue;
+            planted.push_back(text.size());
+            text += (kind == 0 ? "+" : "00 ") + code + " " + digits(national, static_cast<char>('1' + rng() % 9));
+        }
+        else if (kind < 4)
+        {
+            decoys.push_back(text.size());
+            text += "+" + digits(7 + rng() % 9, static_cast<char>('1' + rng() % 9));
+        }
+        else if (kind < 5)
+        {
+            decoys.push_back(text.size());
+            text += "00" + digits(6 + rng() % 10, static_cast<char>('0' + rng() % 10));
+        }
+        text += ' ';
+    }
+
+    const PhoneScanner scanner;
+    size_t found = 0, falsePlus = 0, false00 = 0;
+    scanner.scan(text, [&](const PhoneMatchView &match)
+                 {
+        if (match.type != PhoneType::INTERNATIONAL_PLUS && match.type != PhoneType::INTERNATIONAL_00)
+            return;
+        if (std::binary_search(planted.begin(), planted.end(), match.position))
+            ++found;
+        else if (std::binary_search(decoys.begin(), decoys.end(), match.position))
+            ++(match.type == PhoneType::INTERNATIONAL_PLUS ? falsePlus : false00); });
+
+    // The same text, and generated text, with and without INTERNATIONAL_00.
+    const PhoneScannerFor<PhoneType::FORMATTED_DOMESTIC, PhoneType::FORMATTED_TOLL_FREE, PhoneType::INTERNATIONAL_PLUS,
+                          PhoneType::PLAIN_10_DIGIT, PhoneType::PLAIN_11_DIGIT, PhoneType::MOBILE_10_DIGIT>
+        without00;
+    scenario.spec.documents = 2;
+    scenario.spec.minSize = scenario.spec.maxSize = size;
+    const std::vector<std::string> corpora[] = {{text}, {CorpusGenerator(scenario.spec, seed).document()}};
+    for (const auto &docs : corpora)
+    {
+        const std::string suffix = &docs == &corpora[0] ? "@international" : "@generated";
+        const Bench bench(docs, docs[0].size(), rounds);
+        scenario.bytes += docs[0].size();
+        scenario.engines.push_back(bench.wholeCorpus("fused.count" + suffix, [&]()
+                                                     { return scanner.count(docs[0]); }));
+        if (&docs == &corpora[0])
+            scenario.engines.back().metrics = {{"planted", static_cast<double>(planted.size())},
+                                               {"planted_found", static_cast<double>(found)},
+                                               {"decoys", static_cast<double>(decoys.size())},
+                                               {"decoys_accepted_plus", static_cast<double>(falsePlus)},
+                                               {"decoys_accepted_00", static_cast<double>(false00)}};
+        scenario.engines.push_back(bench.wholeCorpus("without-00.count" + suffix, [&]()
+                                                     { return without00.count(docs[0]); }));
+    }
+
+    // The table lookup on its own, on random three-digit leads.
+    std::string leads(3 << 16, '0');
+    for (char &c : leads)
+        c = static_cast<char>('0' + rng() % 10);
+    const size_t lookups = leads.size() / 3 * 50 * static_cast<size_t>(rounds);
+    size_t valid = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t n = 0; n < lookups; ++n)
+        valid += CallingCodes::isValidNumber(leads.data() + n % (leads.size() / 3) * 3, 7 + (n & 7));
+    const double seconds = nanosSince(start) / 1e9;
+    scenario.engines.push_back(timedEvents("callingcodes.isValidNumber", seconds, lookups, 0, valid, 0));
+    scenario.engines.back().metrics = {{"ns_per_lookup", seconds * 1e9 / static_cast<double>(lookups)}};
+    return scenario;
+}
+
+ScenarioResult runCustomFormatScenario(uint64_t seed, int rounds, bool quick)
+{
+    ScenarioResult scenario;
+    scenario.spec.documents = quick ? 400 : 4000;
+    scenario.spec.minSize = 40;
+    scenario.spec.maxSize = 240;
+    scenario.spec.density = 4.0;
+    const std::vector<std::string> docs = CorpusGenerator(scenario.spec, seed).corpus();
+    for (const auto &doc : docs)
+        scenario.bytes += doc.size();
+
+    // National layouts on top of builtin(): what a deployment would register.
+    const char *const national[] = {
+        "0DDDD DDDDDD",          "0DDD DDD DDDD",        "0DD DDDD DDDD",        "+44 DDDD DDDDDD",
+        "+44 (0)DDDD DDDDDD",    "0DDD DDDDDDD",         "0DDDD DDDDDD",         "+49 DDD DDDDDDD",
+        "+49 (0)DDD DDDDDDD",    "0D DD DD DD DD",       "0D.DD.DD.DD.DD",       "+33 D DD DD DD DD",
+        "+33 (0)D DD DD DD DD",  "0DD DDD DDDD",         "+39 DDD DDD DDDD",     "NDD DD DD DD",
+        "+34 NDD DDD DDD",       "+34 NDD DD DD DD",     "0D-DDDD-DDDD",         "0DD-DDDD-DDDD",
+        "+81 D-DDDD-DDDD",       "+81 DD-DDDD-DDDD",     "01D-DDD-DDDD",         "01D-DDDD-DDDD",
+        "+82 1D-DDDD-DDDD",      "+86 1DD DDDD DDDD",    "1DD-DDDD-DDDD",        "+61 4DD DDD DDD",
+        "04DD DDD DDD",          "(0D) DDDD DDDD",       "+55 DD DDDDD-DDDD",    "(DD) DDDDD-DDDD",
+        "+52 DD DDDD DDDD",      "+7 DDD DDD-DD-DD",     "8 (DDD) DDD-DD-DD",    "+31 6 DDDDDDDD",
+        "06-DDDDDDDD",           "+46 7D-DDD DD DD",     "07D-DDD DD DD",        "+27 DD DDD DDDD",
+    };
+    PhoneFormatSet extended = PhoneFormatSet::builtin();
+    for (const char *pattern : national)
+        extended.add(pattern, PhoneType::MOBILE_10_DIGIT);
+
+    auto compile = [](const PhoneFormatSet &formats, double &milliseconds)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto compiled = std::make_unique<CustomPhoneScanner>(formats);
+        milliseconds = nanosSince(start) / 1e6;
+        return compiled;
+    };
+    double defaultsMs = 0, customMs = 0;
+    const PhoneScanner scanner;
+    const auto defaults = compile(PhoneFormatSet::builtin(), defaultsMs);
+    const auto custom = compile(extended, customMs);
+
+    // As in the corpus scenarios, only the documents where builtin() finds as
+    // many matches as PhoneScanner are timed.
+    std::vector<std::string> agreeing;
+    size_t agreeingBytes = 0;
+    for (const auto &doc : docs)
+        if (defaults->count(doc) == scanner.count(doc))
+        {
+            agreeing.push_back(doc);
+            agreeingBytes += doc.size();
+        }
+    scenario.customDocuments = agreeing.size();
+    if (agreeing.empty())
+        return scenario;
+
+    const Bench bench(agreeing, agreeingBytes, rounds);
+    auto &out = scenario.engines;
+    out.push_back(bench.perDocument("custom.reference", [&](const std::string &doc)
+                                    { return scanner.count(doc); }));
+    out.push_back(bench.perDocument("custom.builtin", [&](const std::string &doc)
+                                    { return defaults->count(doc); }));
+    out.back().metrics = {{"formats", static_cast<double>(PhoneFormatSet::builtin().size())},
+                          {"states", static_cast<double>(defaults->stateCount())},
+                          {"byte_classes", static_cast<double>(defaults->byteClassCount())},
+                          {"compile_ms", defaultsMs}};
+    out.push_back(bench.perDocument("custom.national", [&](const std::string &doc)
+                                    { return custom->count(doc); }));
+    out.back().metrics = {{"formats", static_cast<double>(extended.size())},
+                          {"states", static_cast<double>(custom->stateCount())},
+                          {"byte_classes", static_cast<double>(custom->byteClassCount())},
+                          {"compile_ms", customMs}};
+    return scenario;
+}
+
+ScenarioResult runCacheScenario(uint64_t seed, int rounds, bool quick)
+{
+    ScenarioResult scenario;
+    scenario.spec.documents = quick ? 10000 : 100000;
+    scenario.spec.minSize = 100;
+    scenario.spec.maxSize = 500;
+    scenario.spec.density = 3.0;
+
+    // Notification-style traffic: with probability `ratio` a message repeats
+    // one of 1,000 templates, otherwise it is new. Each stream is scanned once,
+    // through a fresh cache, so misses are counted as they happen.
+    CorpusGenerator generator(scenario.spec, seed);
+    std::vector<std::string> templates;
+    size_t templateBytes = 0;
+    for (int n = 0; n < 1000; ++n)
+    {
+        templates.push_back(generator.document());
+        templateBytes += templates.back().size();
+    }
+
+    const PhoneScanner scanner;
+    std::mt19937_64 rng(seed);
+    for (double ratio : {0.0, 0.5, 0.9, 0.99})
+    {
+        std::vector<std::string> stream;
+        size_t bytes = 0;
+        for (size_t n = 0; n < scenario.spec.documents; ++n)
+        {
+            const bool repeat = std::uniform_real_distribution<double>(0, 1)(rng) < ratio;
+            stream.push_back(repeat ? templates[rng() % templates.size()] : generator.document());
+            bytes += stream.back().size();
+        }
+        scenario.bytes = std::max(scenario.bytes, bytes);
+
+        const std::string suffix = "@" + std::to_string(static_cast<int>(ratio * 100)) + "%";
+        auto once = [&](const std::string &engine, auto &&count)
+        {
+            std::vector<double> latencies;
+            latencies.reserve(stream.size());
+            size_t found = 0;
+            double seconds = 0;
+            const uint64_t before = heapAllocations.load();
+            for (const auto &text : stream)
+            {
+                auto start = std::chrono::steady_clock::now();
+                found += count(text);
+                latencies.push_back(nanosSince(start));
+                seconds += latencies.back() / 1e9;
+            }
+            return timedEvents(engine + suffix, seconds, stream.size(), static_cast<double>(bytes), found,
+                               heapAllocations.load() - before, std::move(latencies));
+        };
+        scenario.engines.push_back(once("fused.count", [&](const std::string &text)
+                                        { return scanner.count(text); }));
+        const CachedPhoneScanner cache;
+        scenario.engines.push_back(once("cached.count", [&](const std::string &text)
+                                        { return cache.count(text); }));
+        scenario.engines.back().metrics = {{"hit_rate", cache.stats().hitRate()}};
+    }
+
+    // A lookup on its own: hashing, then hashing plus one locked set search.
+    const Bench bench(templates, templateBytes, rounds);
+    scenario.engines.push_back(bench.perDocument("cache.hash", [](const std::string &text)
+                                                 { return static_cast<size_t>(CachedPhoneScanner::hash(text) & 1); }));
+    const CachedPhoneScanner cache;
+    scenario.engines.push_back(bench.perDocument("cached.hit", [&](const std::string &text)
+                                                 { return cache.count(text); }));
+    return scenario;
+}
+
+ScenarioResult runArenaScenario(uint64_t seed, int, bool quick)
+{
+    ScenarioResult scenario;
+    scenario.spec.documents = 4096;
+    scenario.spec.minSize = 60;
+    scenario.spec.maxSize = 300;
+    scenario.spec.density = 4.0;
+    const std::vector<std::string> docs = CorpusGenerator(scenario.spec, seed).corpus();
+    for (const auto &doc : docs)
+        scenario.bytes += doc.size();
+
+    // Request handlers: each thread extracts batches of 32 documents, with the
+    // global allocator or with its own PhoneArena reset after every batch. The
+    // counting operator new adds a little to the global allocator's side.
+    const PhoneScanner scanner;
+    const size_t batchSize = 32, rounds = 8;
+    const size_t batches = docs.size() / batchSize;
+    auto run = [&](size_t threadCount, bool useArena)
+    {
+        const uint64_t before = heapAllocations.load();
+        std::vector<std::vector<double>> latencies(threadCount);
+        std::atomic<size_t> found{0};
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t t = 0; t < threadCount; ++t)
+            threads.emplace_back([&, t]
+                                 {
+                PhoneArena arena;
+                size_t local = 0;
+                for (size_t r = 0; r < rounds; ++r)
+                    for (size_t b = t; b < batches; b += threadCount)
+                    {
+                        auto batchStart = std::chrono::steady_clock::now();
+                        for (size_t d = b * batchSize; d < (b + 1) * batchSize; ++d)
+                            local += useArena ? scanner.extract(docs[d], &arena).size() : scanner.extract(docs[d]).size();
+                        arena.reset();
+                        latencies[t].push_back(nanosSince(batchStart));
+                    }
+                found += local; });
+        for (auto &thread : threads)
+            thread.join();
+        const double seconds = nanosSince(start) / 1e9;
+        const uint64_t allocations = heapAllocations.load() - before;
+        std::vector<double> all;
+        for (const auto &perThread : latencies)
+            all.insert(all.end(), perThread.begin(), perThread.end());
+        const std::string engine = std::string(useArena ? "extract.arena" : "extract.global") + "@" +
+                                   std::to_string(threadCount) + "t";
+        return timedEvents(engine, seconds, docs.size() * rounds, static_cast<double>(scenario.bytes) * rounds,
+                           found.load(), allocations, std::move(all), rounds);
+    };
+
+    std::vector<size_t> threadCounts = {1, 2, 4, 8, 16, 32, 64};
+    if (quick)
+        threadCounts.resize(4);
+    for (size_t threads : threadCounts)
+    {
+        scenario.engines.push_back(run(threads, false));
+        scenario.engines.push_back(run(threads, true));
+    }
+    return scenario;
+}
+
+struct FeatureScenario
+{
+    const char *name;
+    const char *description;
+    ScenarioResult (*run)(uint64_t seed, int rounds, bool quick);
+};
+
+const FeatureScenario FEATURE_SCENARIOS[] = {
+    {"incremental", "one-character edits to 100 KB-8 MB documents; latency per edit, MB/s of document per edit",
+     runIncrementalScenario},
+    {"calling-codes", "planted international numbers and decoys, with and without INTERNATIONAL_00",
+     runCallingCodeScenario},
+    {"custom-formats", "builtin() and 40 national layouts as runtime patterns, on the documents builtin() agrees on",
+     runCustomFormatScenario},
+    {"cache", "message streams repeating 0-99% of 1,000 templates, each scanned once through a fresh cache",
+     runCacheScenario},
+    {"arena", "batches of 32 documents per thread, global allocator vs PhoneArena; latency per batch",
+     runArenaScenario},
+};
+
+// ============================================================================
+// LINEARITY
+// ============================================================================
+
+// Inputs built to make a backtracking scanner rescan: each unit is repeated to
+// the measured size. "near-misses" is generated text made only of the
+// corpus generator's near-miss tokens.
+struct PathologicalPattern
+{
+    const char *name;
+    const char *unit;
+};
+
+const PathologicalPattern PATHOLOGICAL_PATTERNS[] = {
+    {"plus-runs", "+1-"},
+    {"open-parens", "(((123) "},
+    {"dash-runs", "1-"},
+    {"space-runs", "1 "},
+    {"digit-runs", "0123456789"},
+    {"plus-parens", "+("},
+    {"short-formatted", "(123) 456-789 "},
+    {"short-separated", "123-456-789."},
+    {"short-mobile", "9999 9999 "},
+    {"long-intl", "+1 (234) 567-89 "},
+    {"dense-valid", "(234) 567-8900 "},
+    {"zero-zero-runs", "00 "},
+    {"near-misses", nullptr},
+};
+
+// Largest accepted growth of ns/byte between the smallest and largest size.
+constexpr double LINEARITY_TOLERANCE = 3.0;
+
+struct LinearityResult
+{
+    std::string pattern;
+    std::string engine;
+    std::vector<size_t> sizes;
+    std::vector<double> nsPerByte;
+    double growth = 0;
+
+    bool linear() const { return growth < LINEARITY_TOLERANCE; }
+};
+
+std::string pathologicalText(const PathologicalPattern &pattern, size_t size, uint64_t seed)
+{
+    if (!pattern.unit)
+    {
+        CorpusSpec spec;
+        spec.minSize = spec.maxSize = size;
+        spec.density = 0.0;
+        spec.adversarial = 1.0;
+        return CorpusGenerator(spec, seed).document();
+    }
+
+    const std::string unit = pattern.unit;
+    std::string text;
+    text.reserve(size + unit.size());
+    while (text.size() < size)
+        text += unit;
+    text.resize(size);
+    return text;
+}
+
+// Best of rounds after one warm-up run; the minimum is the least noisy
+// estimate of the cost per byte.
+template <typename Fn>
+double bestNanosPerByte(const std::string &text, int rounds, Fn &&fn)
+{
+    volatile size_t sink = fn(text);
+    double best = 0;
+    for (int r = 0; r < rounds; ++r)
+    {
+        auto start = std::chrono::steady_clock::now();
+        sink = sink + fn(text);
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        best = r == 0 ? ns : std::min(best, ns);
+    }
+    return best / static_cast<double>(text.size());
+}
+
+std::vector<LinearityResult> runLinearity(uint64_t seed, int rounds, bool quick)
+{
+    std::vector<size_t> sizes = {16 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024};
+    if (quick)
+        sizes.pop_back();
+
+    const PhoneScanner scanner;
+    const CustomPhoneScanner custom(PhoneFormatSet::builtin());
+    using Engine = std::pair<const char *, std::function<size_t(const std::string &)>>;
+    const Engine engines[] = {
+        {"fused.count", [&](const std::string &text)
+         { return scanner.count(text); }},
+        {"fused.extractViews", [&](const std::string &text)
+         { return scanner.extractViews(text).size(); }},
+        {"multipass.extract", [&](const std::string &text)
+         { return scanner.extractMultiPass(text).size(); }},
+        {"stream.feed", [&](const std::string &text)
+         {
+             StreamingPhoneScanner stream;
+             return stream.feed(text).size() + stream.finish().size();
+         }},
+        {"redact.writer", [&](const std::string &text)
+         { return scanner.redact(text, [](std::string_view) {}); }},
+        {"custom.count", [&](const std::string &text)
+         { return custom.count(text); }},
+    };
+
+    std::vector<LinearityResult> results;
+    for (const auto &pattern : PATHOLOGICAL_PATTERNS)
+    {
+        std::vector<std::string> texts;
+        for (size_t size : sizes)
+            texts.push_back(pathologicalText(pattern, size, seed));
+
+        for (const auto &[engine, fn] : engines)
+        {
+            LinearityResult result;
+            result.pattern = pattern.name;
+            result.engine = engine;
+            result.sizes = sizes;
+            for (const auto &text : texts)
+                result.nsPerByte.push_back(bestNanosPerByte(text, rounds, fn));
+            result.growth = result.nsPerByte.back() / std::max(result.nsPerByte.front(), 1e-9);
+            results.push_back(std::move(result));
+        }
+    }
+    return results;
+}
+
+// ============================================================================
+// OUTPUT
+// ============================================================================
+
+const char *prefilterLevelName(CandidatePrefilter::Level level)
+{
+    switch (level)
+    {
+    case CandidatePrefilter::Level::AVX2:
+        return "AVX2";
+    case CandidatePrefilter::Level::SSE2:
+        return "SSE2";
+    default:
+        return "SCALAR";
+    }
+}
+
+void printTable(const ScenarioResult &scenario)
+{
+    const CorpusSpec &spec = scenario.spec;
+    if (scenario.description.empty())
+        std::printf("\n=== %s: %zu docs, %zu-%zu bytes, %.2f numbers/KB, %.0f%% near-misses, %zu bytes total ===\n",
+                    spec.name.c_str(), spec.documents, spec.minSize, spec.maxSize, spec.density, spec.adversarial * 100,
+                    scenario.bytes);
+    else
+        std::printf("\n=== %s: %s ===\n", spec.name.c_str(), scenario.description.c_str());
+    std::printf("%-30s %10s %12s %12s %10s %10s %10s %9s %9s\n", "engine", "MB/s", "docs/s", "matches/s",
+                "p50 ns", "p99 ns", "p999 ns", "allocs", "matches");
+    for (const auto &r : scenario.engines)
+    {
+        if (r.hasLatency)
+            std::printf("%-30s %10.1f %12.0f %12.0f %10.0f %10.0f %10.0f %9.2f %9zu", r.engine.c_str(),
+                        r.bytesPerSecond / (1024.0 * 1024.0), r.docsPerSecond, r.matchesPerSecond, r.p50, r.p99, r.p999,
+                        r.allocationsPerDoc, r.matches);
+        else
+            std::printf("%-30s %10.1f %12.0f %12.0f %10s %10s %10s %9.2f %9zu", r.engine.c_str(),
+                        r.bytesPerSecond / (1024.0 * 1024.0), r.docsPerSecond, r.matchesPerSecond, "-", "-", "-",
+                        r.allocationsPerDoc, r.matches);
+        for (const auto &[name, value] : r.metrics)
+            std::printf("  %s=%.6g", name.c_str(), value);
+        std::printf("\n");
+    }
+    if (scenario.description.empty() || scenario.customDocuments)
+        std::printf("custom.*: %zu of %zu documents, where builtin() finds as many matches as PhoneScanner\n",
+                    scenario.customDocuments, spec.documents);
+}
+
+void printLinearity(const std::vector<LinearityResult> &results)
+{
+    if (results.empty())
+        return;
+    std::printf("\n=== linearity: ns/byte by input size, growth = largest / smallest (limit %.1fx) ===\n",
+                LINEARITY_TOLERANCE);
+    std::printf("%-16s %-20s", "pattern", "engine");
+    for (size_t size : results.front().sizes)
+        std::printf(" %7zuK", size / 1024);
+    std::printf(" %8s\n", "growth");
+    for (const auto &r : results)
+    {
+        std::printf("%-16s %-20s", r.pattern.c_str(), r.engine.c_str());
+        for (double ns : r.nsPerByte)
+            std::printf(" %8.2f", ns);
+        std::printf(" %7.2fx%s\n", r.growth, r.linear() ? "" : "  NOT LINEAR");
+    }
+}
+
+std::string toJson(const std::vector<ScenarioResult> &scenarios, const std::vector<LinearityResult> &linearity,
+                   uint64_t seed, int rounds)
+{
+    std::ostringstream json;
+    json.precision(6);
+    json << "{\n  \"seed\": " << seed << ",\n  \"rounds\": " << rounds
+         << ",\n  \"prefilter\": \"" << prefilterLevelName(CandidatePrefilter::bestLevel()) << "\""
+#ifdef __VERSION__
+         << ",\n  \"compiler\": \"" << __VERSION__ << "\""
+#endif
+         << ",\n  \"hardware_threads\": " << std::thread::hardware_concurrency()
+         << ",\n  \"scenarios\": [";
+    for (size_t s = 0; s < scenarios.size(); ++s)
+    {
+        const ScenarioResult &scenario = scenarios[s];
+        const CorpusSpec &spec = scenario.spec;
+        json << (s ? "," : "") << "\n    {\n      \"name\": \"" << spec.name << "\"";
+        if (!scenario.description.empty())
+            json << ",\n      \"description\": \"" << scenario.description << "\"";
+        json << ",\n      \"documents\": " << spec.documents << ",\n      \"bytes\": " << scenario.bytes
+             << ",\n      \"min_size\": " << spec.minSize << ",\n      \"max_size\": " << spec.maxSize
+             << ",\n      \"density_per_kb\": " << spec.density << ",\n      \"adversarial\": " << spec.adversarial
+             << ",\n      \"custom_documents\": " << scenario.customDocuments
+             << ",\n      \"mix\": {";
+        for (size_t t = 0; t < GENERATED_TYPE_COUNT; ++t)
+            json << (t ? ", " : "") << "\"" << MIX_NAMES[t] << "\": " << spec.mix[t];
+        json << "},\n      \"results\": [";
+        for (size_t e = 0; e < scenario.engines.size(); ++e)
+        {
+            const EngineResult &r = scenario.engines[e];
+            json << (e ? "," : "") << "\n        {\"engine\": \"" << r.engine << "\", \"bytes_per_sec\": " << r.bytesPerSecond
+                 << ", \"docs_per_sec\": " << r.docsPerSecond << ", \"matches_per_sec\": " << r.matchesPerSecond
+                 << ", \"allocs_per_doc\": " << r.allocationsPerDoc << ", \"matches\": " << r.matches;
+            if (r.hasLatency)
+                json << ", \"p50_ns\": " << r.p50 << ", \"p99_ns\": " << r.p99 << ", \"p999_ns\": " << r.p999;
+            else
+                json << ", \"p50_ns\": null, \"p99_ns\": null, \"p999_ns\": null";
+            if (!r.metrics.empty())
+            {
+                json << ", \"metrics\": {";
+                for (size_t m = 0; m < r.metrics.size(); ++m)
+                    json << (m ? ", " : "") << "\"" << r.metrics[m].first << "\": " << r.metrics[m].second;
+                json << "}";
+            }
+            json << "}";
+        }
+        json << "\n      ]\n    }";
+    }
+    json << "\n  ],\n  \"linearity\": [";
+    for (size_t l = 0; l < linearity.size(); ++l)
+    {
+        const LinearityResult &r = linearity[l];
+        json << (l ? "," : "") << "\n    {\"pattern\": \"" << r.pattern << "\", \"engine\": \"" << r.engine
+             << "\", \"sizes\": [";
+        for (size_t i = 0; i < r.sizes.size(); ++i)
+            json << (i ? ", " : "") << r.sizes[i];
+        json << "], \"ns_per_byte\": [";
+        for (size_t i = 0; i < r.nsPerByte.size(); ++i)
+            json << (i ? ", " : "") << r.nsPerByte[i];
+        json << "], \"growth\": " << r.growth << ", \"linear\": " << (r.linear() ? "true" : "false") << "}";
+    }
+    json << "\n  ]\n}\n";
+    return json.str();
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+struct Options
+{
+    std::vector<std::string> scenarios;
+    uint64_t seed = 42;
+    int rounds = 3;
+    bool quick = false;
+    bool list = false;
+    bool linearity = false;
+    std::string jsonPath;
+
+    // Any of these turns the run into a single "custom" scenario.
+    bool custom = false;
+    CorpusSpec overrides;
+};
+
+void printUsage()
+{
+    std::cerr << "Usage: PhoneBenchmark [options]\n"
+              << "  --scenario NAME        run a built-in scenario (repeatable; default: all, see --list)\n"
+              << "  --seed N               corpus seed (default: 42)\n"
+              << "  --rounds N             timed rounds per engine (default: 3)\n"
+              << "  --quick                smaller corpora, for a fast check\n"
+              << "  --json FILE|-          also write results as JSON\n"
+              << "  --list                 list the built-in corpus and feature scenarios\n"
+              << "  --linearity            time pathological inputs from 16 KB to 4 MB (alone, replaces the scenarios);\n"
+              << "                         exits with status 3 if any engine's ns/byte grows by "
+              << LINEARITY_TOLERANCE << "x or more\n"
+              << "Custom corpus (replaces the built-in scenarios):\n"
+              << "  --docs N               number of documents\n"
+              << "  --size MIN[:MAX]       document size in bytes (100 B to 100 MB and beyond)\n"
+              << "  --density D            planted numbers per KB\n"
+              << "  --adversarial F        fraction of filler tokens replaced by near-misses (0-1)\n"
+              << "  --mix type=w,...       format weights; types: domestic tollfree intl intl00 plain10 plain11 mobile\n";
+}
+
+bool parseMix(const std::string &text, CorpusSpec &spec)
+{
+    std::fill(std::begin(spec.mix), std::end(spec.mix), 0.0);
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        const size_t eq = item.find('=');
+        if (eq == std::string::npos)
+            return false;
+        const std::string name = item.substr(0, eq);
+        size_t t = 0;
+        while (t < GENERATED_TYPE_COUNT && name != MIX_NAMES[t])
+            ++t;
+        if (t == GENERATED_TYPE_COUNT)
+            return false;
+        spec.mix[t] = std::strtod(item.c_str() + eq + 1, nullptr);
+    }
+    return true;
+}
+
+bool parseOptions(int argc, char **argv, Options &options)
+{
+    options.overrides.name = "custom";
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--scenario" && hasValue)
+            options.scenarios.push_back(argv[++i]);
+        else if (arg == "--seed" && hasValue)
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--rounds" && hasValue)
+            options.rounds = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--json" && hasValue)
+            options.jsonPath = argv[++i];
+        else if (arg == "--quick")
+            options.quick = true;
+        else if (arg == "--list")
+            options.list = true;
+        else if (arg == "--linearity")
+            options.linearity = true;
+        else if (arg == "--docs" && hasValue)
+        {
+            options.custom = true;
+            options.overrides.documents = std::max<size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--size" && hasValue)
+        {
+            options.custom = true;
+            char *end = nullptr;
+            options.overrides.minSize = options.overrides.maxSize = std::strtoull(argv[++i], &end, 10);
+            if (*end == ':')
+                options.overrides.maxSize = std::strtoull(end + 1, nullptr, 10);
+            if (options.overrides.maxSize < options.overrides.minSize)
+                return false;
+        }
+        else if (arg == "--density" && hasValue)
+        {
+            options.custom = true;
+            options.overrides.density = std::max(0.0, std::strtod(argv[++i], nullptr));
+        }
+        else if (arg == "--adversarial" && hasValue)
+        {
+            options.custom = true;
+            options.overrides.adversarial = std::min(1.0, std::max(0.0, std::strtod(argv[++i], nullptr)));
+        }
+        else if (arg == "--mix" && hasValue)
+        {
+            options.custom = true;
+            if (!parseMix(argv[++i], options.overrides))
+                return false;
+        }
+        else
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<CorpusSpec> selected;
+    std::vector<const FeatureScenario *> features;
+    const std::vector<CorpusSpec> builtin = builtinScenarios(options.quick);
+    if (options.list)
+    {
+        for (const auto &spec : builtin)
+            std::printf("%-14s %6zu docs, %zu-%zu bytes, %.2f numbers/KB, %.0f%% near-misses\n", spec.name.c_str(),
+                        spec.documents, spec.minSize, spec.maxSize, spec.density, spec.adversarial * 100);
+        for (const auto &feature : FEATURE_SCENARIOS)
+            std::printf("%-14s %s\n", feature.name, feature.description);
+        return 0;
+    }
+    if (options.custom)
+        selected.push_back(options.overrides);
+    else if (options.scenarios.empty() && !options.linearity)
+    {
+        selected = builtin;
+        for (const auto &feature : FEATURE_SCENARIOS)
+            features.push_back(&feature);
+    }
+    else
+    {
+        for (const auto &name : options.scenarios)
+        {
+            auto it = std::find_if(builtin.begin(), builtin.end(), [&](const CorpusSpec &spec)
+                                   { return spec.name == name; });
+            auto feature = std::find_if(std::begin(FEATURE_SCENARIOS), std::end(FEATURE_SCENARIOS),
+                                        [&](const FeatureScenario &f)
+                                        { return name == f.name; });
+            if (it != builtin.end())
+                selected.push_back(*it);
+            else if (feature != std::end(FEATURE_SCENARIOS))
+                features.push_back(feature);
+            else
+            {
+                std::cerr << "PhoneBenchmark: unknown scenario " << name << " (see --list)\n";
+                return 1;
+            }
+        }
+    }
+
+    std::printf("PhoneBenchmark: seed %llu, %d rounds, prefilter %s\n", static_cast<unsigned long long>(options.seed),
+                options.rounds, prefilterLevelName(CandidatePrefilter::bestLevel()));
+
+    std::vector<ScenarioResult> results;
+    for (const auto &spec : selected)
+    {
+        results.push_back(runScenario(spec, options.seed, options.rounds));
+        printTable(results.back());
+        std::fflush(stdout);
+    }
+    for (const FeatureScenario *feature : features)
+    {
+        results.push_back(feature->run(options.seed, options.rounds, options.quick));
+        results.back().spec.name = feature->name;
+        results.back().description = feature->description;
+        printTable(results.back());
+        std::fflush(stdout);
+    }
+
+    std::vector<LinearityResult> linearity;
+    if (options.linearity)
+    {
+        linearity = runLinearity(options.seed, options.rounds, options.quick);
+        printLinearity(linearity);
+        std::fflush(stdout);
+    }
+
+    if (!options.jsonPath.empty())
+    {
+        const std::string json = toJson(results, linearity, options.seed, options.rounds);
+        if (options.jsonPath == "-")
+            std::fwrite(json.data(), 1, json.size(), stdout);
+        else
+        {
+            std::ofstream file(options.jsonPath);
+            file << json;
+            if (!file)
+            {
+                std::cerr << "PhoneBenchmark: cannot write " << options.jsonPath << "\n";
+                return 2;
+            }
+        }
+    }
+
+    for (const auto &r : linearity)
+        if (!r.linear())
+            return 3;
+    return 0;
+}
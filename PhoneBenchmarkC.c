@@ -0,0 +1,175 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "PhoneDetectorC.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * PhoneBenchmarkC - C driver for the shared library
+ *
+ *   PhoneBenchmarkC [DOCUMENTS]
+ *
+ * Generates short messages, checks that batched, per-document and resumed
+ * calls return the same matches (exit status 1 if not), then times the
+ * boundary: an empty call, which is everything a call costs besides the
+ * scan, and one call per document against batches of growing size. The
+ * per-document boundary cost is the empty call divided by the batch size.
+ */
+
+static const char *const WORDS[] = {"please", "call", "order", "#48213", "at", "2024-06-11", "12:30", "or", "ext.", "42",
+                                    "(234) 567-8900", "+91-9876543210", "99887 76655", "1-800-555-0199", "2345678901",
+                                    "+44 20 7946 0123", "345.678.9012", "9123456789", "thanks", "ref", "7730019",
+                                    "0044 20 7946 0958"};
+
+static uint64_t rngState = 42;
+
+static uint32_t nextRandom(void)
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return (uint32_t)(rngState >> 32);
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int sameMatch(const phone_match *a, const phone_match *b, uint32_t documentOffset)
+{
+    return a->document + documentOffset == b->document && a->offset == b->offset && a->length == b->length &&
+           a->type == b->type;
+}
+
+int main(int argc, char **argv)
+{
+    const size_t count = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 100000;
+    if (count == 0 || phone_api_version() != PHONE_API_VERSION)
+    {
+        fprintf(stderr, "usage: PhoneBenchmarkC [DOCUMENTS > 0] (library API %u, header %d)\n", phone_api_version(),
+                PHONE_API_VERSION);
+        return 2;
+    }
+
+    /* Corpus: 100-500 byte messages in one buffer. */
+    phone_document *documents = malloc(count * sizeof(*documents));
+    size_t *starts = malloc(count * sizeof(*starts));
+    size_t bytes = 0, reserved = count * 520, maxLength = 0;
+    char *text = malloc(reserved);
+    if (!documents || !starts || !text)
+        return 2;
+    for (size_t d = 0; d < count; ++d)
+    {
+        const size_t target = 100 + nextRandom() % 400;
+        starts[d] = bytes;
+        while (bytes - starts[d] < target)
+        {
+            const char *word = WORDS[nextRandom() % (sizeof(WORDS) / sizeof(WORDS[0]))];
+            const size_t length = strlen(word);
+            memcpy(text + bytes, word, length);
+            text[bytes + length] = ' ';
+            bytes += length + 1;
+        }
+        documents[d].length = bytes - starts[d];
+        if (documents[d].length > maxLength)
+            maxLength = documents[d].length;
+    }
+    for (size_t d = 0; d < count; ++d)
+        documents[d].data = text + starts[d];
+
+    phone_scanner *scanner = phone_scanner_create();
+    const size_t capacity = count * phone_max_matches(maxLength);
+    phone_match *all = malloc(capacity * sizeof(*all));
+    phone_match *part = malloc(capacity * sizeof(*part));
+    if (!scanner || !all || !part)
+        return 2;
+
+    /* Correctness: one batch, one call per document, and resumed small buffers agree. */
+    size_t total = 0, scanned = 0;
+    int ok = phone_scan_batch(scanner, documents, count, all, capacity, &total, &scanned) == PHONE_OK && scanned == count;
+    size_t next = 0;
+    for (size_t d = 0; ok && d < count; ++d)
+    {
+        size_t found = 0;
+        ok = phone_scan_batch(scanner, documents + d, 1, part, capacity, &found, &scanned) == PHONE_OK;
+        for (size_t m = 0; ok && m < found; ++m)
+            ok = next < total && sameMatch(&part[m], &all[next++], (uint32_t)d);
+    }
+    ok = ok && next == total;
+    const size_t smallCapacity = phone_max_matches(maxLength);
+    size_t done = 0;
+    next = 0;
+    while (ok && done < count)
+    {
+        size_t found = 0;
+        const int status = phone_scan_batch(scanner, documents + done, count - done, part, smallCapacity, &found, &scanned);
+        ok = (status == PHONE_OK || status == PHONE_BUFFER_FULL) && (scanned > 0 || status == PHONE_OK);
+        for (size_t m = 0; ok && m < found; ++m)
+            ok = next < total && sameMatch(&part[m], &all[next++], (uint32_t)done);
+        done += scanned;
+    }
+    ok = ok && next == total;
+    ok = ok && phone_scan_batch(NULL, documents, count, all, capacity, &total, &scanned) == PHONE_INVALID_ARGUMENT &&
+         scanned == 0;
+    printf("%s batched, per-document and resumed calls agree (%zu documents, %zu matches)\n", ok ? "OK  " : "FAIL",
+           count, next);
+    if (!ok)
+        return 1;
+
+    /* Timing. */
+    const int calls = 1000000;
+    double start = now();
+    for (int c = 0; c < calls; ++c)
+        phone_scan_batch(scanner, documents, 0, all, capacity, &total, &scanned);
+    const double emptyNs = (now() - start) * 1e9 / calls;
+
+    size_t batchSizes[] = {1, 16, 256, 4096};
+    const size_t runs = sizeof(batchSizes) / sizeof(batchSizes[0]);
+    double seconds[sizeof(batchSizes) / sizeof(batchSizes[0])];
+    for (size_t b = 0; b < runs; ++b)
+    {
+        batchSizes[b] = batchSizes[b] < count ? batchSizes[b] : count;
+        seconds[b] = 1e300;
+    }
+    /* Rounds visit every batch size in turn, so drift affects them alike. */
+    for (int round = 0; round < 5; ++round)
+        for (size_t b = 0; b < runs; ++b)
+        {
+            const size_t batch = batchSizes[b];
+            start = now();
+            for (size_t first = 0; first < count; first += batch)
+            {
+                const size_t n = count - first < batch ? count - first : batch;
+                phone_scan_batch(scanner, documents + first, n, all, capacity, &total, &scanned);
+            }
+            const double elapsed = now() - start;
+            if (elapsed < seconds[b])
+                seconds[b] = elapsed;
+        }
+
+    printf("\nEmpty call (the boundary alone): %.1f ns\n\n", emptyNs);
+    printf("%-20s %12s %10s %24s\n", "Calls", "ns/document", "MB/s", "boundary per document");
+    for (size_t b = 0; b < runs; ++b)
+    {
+        const double ns = seconds[b] * 1e9 / count;
+        const double boundary = emptyNs / (double)batchSizes[b];
+        char label[64];
+        snprintf(label, sizeof(label), batchSizes[b] == 1 ? "one per document" : "batches of %zu", batchSizes[b]);
+        printf("%-20s %12.1f %10.1f %15.2f ns (%.3f%%)\n", label, ns, bytes / seconds[b] / (1024.0 * 1024.0), boundary,
+               boundary * 100.0 / ns);
+    }
+
+    phone_scanner_destroy(scanner);
+    free(part);
+    free(all);
+    free(text);
+    free(starts);
+    free(documents);
+    return 0;
+}
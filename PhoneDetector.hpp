@@ -0,0 +1,4699 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <memory>
+#include <memory_resource>
+#include <cstring>
+#include <cstdio>
+#include <utility>
+#include <cstdint>
+#include <climits>
+#include <cctype>
+#include <cmath>
+#include <unordered_map>
+#include <map>
+#include <type_traits>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LIKELY(x) __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define FORCE_INLINE __attribute__((always_inline)) inline
+#else
+#define LIKELY(x) (x)
+#define UNLIKELY(x) (x)
+#define FORCE_INLINE inline
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define PHONE_DETECTOR_X86 1
+#include <immintrin.h>
+#else
+#define PHONE_DETECTOR_X86 0
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PHONE_DETECTOR_POSIX 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define PHONE_DETECTOR_POSIX 0
+#endif
+
+enum class PhoneType
+{
+    FORMATTED_DOMESTIC,  // (123) 456-7890, 123-456-7890, 123.456.7890
+    FORMATTED_TOLL_FREE, // 1-800-555-1234, 1.800.555.1234
+    INTERNATIONAL_PLUS,  // +1 123-456-7890, +91-1234567890, +44 20 1234 5678
+    INTERNATIONAL_00,    // 00 1 123-456-7890, 0044 20 1234 5678
+    PLAIN_10_DIGIT,      // 1234567890
+    PLAIN_11_DIGIT,      // 11234567890
+    MOBILE_10_DIGIT,     // 9876543210 (starts with 1-9)
+    UNKNOWN
+};
+
+struct PhoneMatch
+{
+    PhoneType type;
+    std::string value;
+    std::string normalized; // Digits only, without the "00" of INTERNATIONAL_00
+    size_t position;
+
+    PhoneMatch() : type(PhoneType::UNKNOWN), position(0) {}
+    PhoneMatch(PhoneType t, std::string v, std::string n, size_t p)
+        : type(t), value(std::move(v)), normalized(std::move(n)), position(p) {}
+};
+
+// PhoneMatch whose strings allocate from a std::pmr::memory_resource. In a
+// std::pmr::vector the elements take the vector's resource, so one resource
+// (typically a PhoneArena) serves the whole result.
+struct PmrPhoneMatch
+{
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    PhoneType type = PhoneType::UNKNOWN;
+    std::pmr::string value;
+    std::pmr::string normalized; // Digits only, without the "00" of INTERNATIONAL_00
+    size_t position = 0;
+
+    PmrPhoneMatch() = default;
+    explicit PmrPhoneMatch(allocator_type alloc) : value(alloc), normalized(alloc) {}
+    PmrPhoneMatch(PhoneType t, std::string_view v, std::string_view n, size_t p, allocator_type alloc = {})
+        : type(t), value(v, alloc), normalized(n, alloc), position(p) {}
+    PmrPhoneMatch(const PmrPhoneMatch &other) = default;
+    PmrPhoneMatch(PmrPhoneMatch &&other) = default;
+    PmrPhoneMatch(const PmrPhoneMatch &other, allocator_type alloc)
+        : type(other.type), value(other.value, alloc), normalized(other.normalized, alloc), position(other.position) {}
+    PmrPhoneMatch(PmrPhoneMatch &&other, allocator_type alloc)
+        : type(other.type), value(std::move(other.value), alloc), normalized(std::move(other.normalized), alloc),
+          position(other.position) {}
+    PmrPhoneMatch &operator=(const PmrPhoneMatch &other) = default;
+    PmrPhoneMatch &operator=(PmrPhoneMatch &&other) = default;
+
+    allocator_type get_allocator() const noexcept { return value.get_allocator(); }
+};
+
+inline const char *phoneTypeToString(PhoneType type) noexcept
+{
+    switch (type)
+    {
+    case PhoneType::FORMATTED_DOMESTIC:
+        return "FORMATTED_DOMESTIC";
+    case PhoneType::FORMATTED_TOLL_FREE:
+        return "FORMATTED_TOLL_FREE";
+    case PhoneType::INTERNATIONAL_PLUS:
+        return "INTERNATIONAL_PLUS";
+    case PhoneType::INTERNATIONAL_00:
+        return "INTERNATIONAL_00";
+    case PhoneType::PLAIN_10_DIGIT:
+        return "PLAIN_10_DIGIT";
+    case PhoneType::PLAIN_11_DIGIT:
+        return "PLAIN_11_DIGIT";
+    case PhoneType::MOBILE_10_DIGIT:
+        return "MOBILE_10_DIGIT";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+// ============================================================================
+// INTERFACES (SOLID Principles)
+// ============================================================================
+
+class IPhoneValidator
+{
+public:
+    virtual ~IPhoneValidator() = default;
+    virtual bool isValid(const std::string &phone) const noexcept = 0;
+    virtual PhoneType getType() const noexcept = 0;
+};
+
+class CharacterClassifier
+{
+private:
+    static constexpr unsigned char CHAR_DIGIT = 0x01;
+    static constexpr unsigned char CHAR_SEPARATOR = 0x02;
+    static constexpr unsigned char CHAR_PLUS = 0x04;
+    static constexpr unsigned char CHAR_OPEN = 0x08;
+
+    inline static constexpr unsigned char charTable[256] = {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0A, 0x02, 0x00, 0x04, 0x00, 0x02, 0x02, 0x00,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+public:
+    static FORCE_INLINE bool isDigit(unsigned char c) noexcept { return (charTable[c] & CHAR_DIGIT) != 0; }
+    static FORCE_INLINE bool isSeparator(unsigned char c) noexcept { return (charTable[c] & CHAR_SEPARATOR) != 0; }
+    static FORCE_INLINE bool isPlus(unsigned char c) noexcept { return (charTable[c] & CHAR_PLUS) != 0; }
+    static FORCE_INLINE bool isPhoneChar(unsigned char c) noexcept { return charTable[c] != 0; }
+    // Digits, '+' and '(' are the only bytes a phone number can start with.
+    static FORCE_INLINE bool isCandidateStart(unsigned char c) noexcept { return (charTable[c] & (CHAR_DIGIT | CHAR_PLUS | CHAR_OPEN)) != 0; }
+};
+
+constexpr unsigned char CharacterClassifier::charTable[256];
+
+// ============================================================================
+// INSTRUMENTATION
+// ============================================================================
+
+// Build with -DPHONE_DETECTOR_STATS=1 to count candidates, rejections and
+// overlap losers and to time the scans. When off, the PHONE_STAT_* macros
+// expand to nothing and phoneScanStats() returns zeros.
+#ifndef PHONE_DETECTOR_STATS
+#define PHONE_DETECTOR_STATS 0
+#endif
+
+// Passes of the reference multi-pass engine, in the order extractMultiPass
+// runs them. The single-pass engine's candidates are counted under the same
+// names: '+' numbers as INTERNATIONAL, parenthesized and separated numbers as
+// FORMATTED, bare digit runs as PLAIN.
+enum class ScanPass
+{
+    INTERNATIONAL,
+    FORMATTED,
+    PLAIN
+};
+
+enum class RejectReason
+{
+    DIGIT_COUNT,    // too few or too many digits
+    AREA_CODE,      // area code starts with 0 (or 1-0 for 11 digits)
+    EXCHANGE_CODE,  // exchange code starts with 0 or 1
+    SEPARATOR,      // no separator, mixed separators or a malformed "(NXX) "
+    PREFIX,          // 11 digits not starting with the trunk prefix 1
+    DISABLED_FORMAT, // valid shape, but the format is not enabled in this scanner
+    CALLING_CODE,    // no country calling code is assigned to the leading digits
+    NATIONAL_LENGTH  // the national number is too short or too long for its calling code
+};
+
+struct ScanStats
+{
+    static constexpr bool ENABLED = PHONE_DETECTOR_STATS != 0;
+    static constexpr size_t PASSES = 3;
+    static constexpr size_t REASONS = 8;
+
+    // Flat layout so per-thread slots can be summed field by field.
+    enum Field : size_t
+    {
+        SCANS,          // single-pass scanRange calls
+        BYTES,          // bytes they covered
+        SCAN_NANOS,     // time spent in them
+        OVERLAP_LOSERS, // valid candidates dropped for overlapping an earlier match
+        CANDIDATES,
+        ACCEPTED = CANDIDATES + PASSES,
+        PASS_NANOS = ACCEPTED + PASSES, // reference engine, per pass
+        REJECTED = PASS_NANOS + PASSES,
+        FIELD_COUNT = REJECTED + PASSES * REASONS
+    };
+
+    static constexpr size_t candidates(ScanPass pass) noexcept { return CANDIDATES + static_cast<size_t>(pass); }
+    static constexpr size_t accepted(ScanPass pass) noexcept { return ACCEPTED + static_cast<size_t>(pass); }
+    static constexpr size_t passNanos(ScanPass pass) noexcept { return PASS_NANOS + static_cast<size_t>(pass); }
+    static constexpr size_t rejected(ScanPass pass, RejectReason reason) noexcept
+    {
+        return REJECTED + static_cast<size_t>(pass) * REASONS + static_cast<size_t>(reason);
+    }
+
+    uint64_t values[FIELD_COUNT] = {};
+
+    uint64_t operator[](size_t field) const noexcept { return values[field]; }
+
+    void merge(const ScanStats &other) noexcept
+    {
+        for (size_t f = 0; f < FIELD_COUNT; ++f)
+            values[f] += other.values[f];
+    }
+
+    static const char *passName(size_t pass) noexcept
+    {
+        static const char *const names[PASSES] = {"INTERNATIONAL", "FORMATTED", "PLAIN"};
+        return names[pass];
+    }
+
+    static const char *reasonName(size_t reason) noexcept
+    {
+        static const char *const names[REASONS] = {"digit_count", "area_code", "exchange_code", "separator",
+                                                   "prefix", "disabled_format", "calling_code", "national_length"};
+        return names[reason];
+    }
+
+    std::string toText() const
+    {
+        std::string out = "Scans: " + std::to_string(values[SCANS]) + ", bytes: " + std::to_string(values[BYTES]) +
+                          ", scan time: " + std::to_string(values[SCAN_NANOS] / 1000000.0) + " ms" +
+                          ", overlap losers: " + std::to_string(values[OVERLAP_LOSERS]) + "\n";
+        for (size_t p = 0; p < PASSES; ++p)
+        {
+            const ScanPass pass = static_cast<ScanPass>(p);
+            out += std::string(passName(p)) + ": candidates " + std::to_string(values[candidates(pass)]) +
+                   ", accepted " + std::to_string(values[accepted(pass)]) + ", rejected";
+            for (size_t r = 0; r < REASONS; ++r)
+                out += std::string(r ? ", " : " ") + reasonName(r) + " " + std::to_string(values[rejected(pass, static_cast<RejectReason>(r))]);
+            out += ", reference pass time " + std::to_string(values[passNanos(pass)] / 1000000.0) + " ms\n";
+        }
+        return out;
+    }
+
+    std::string toJson() const
+    {
+        std::string out = "{\"scans\":" + std::to_string(values[SCANS]) + ",\"bytes\":" + std::to_string(values[BYTES]) +
+                          ",\"scan_ns\":" + std::to_string(values[SCAN_NANOS]) +
+                          ",\"overlap_losers\":" + std::to_string(values[OVERLAP_LOSERS]) + ",\"passes\":{";
+        for (size_t p = 0; p < PASSES; ++p)
+        {
+            const ScanPass pass = static_cast<ScanPass>(p);
+            out += std::string(p ? "," : "") + "\"" + passName(p) + "\":{\"candidates\":" + std::to_string(values[candidates(pass)]) +
+                   ",\"accepted\":" + std::to_string(values[accepted(pass)]) + ",\"rejected\":{";
+            for (size_t r = 0; r < REASONS; ++r)
+                out += std::string(r ? "," : "") + "\"" + reasonName(r) + "\":" + std::to_string(values[rejected(pass, static_cast<RejectReason>(r))]);
+            out += "},\"reference_pass_ns\":" + std::to_string(values[passNanos(pass)]) + "}";
+        }
+        return out + "}}";
+    }
+};
+
+#if PHONE_DETECTOR_STATS
+// One slot of counters per thread. Only the owning thread writes a slot (a
+// relaxed load and store, no locked instruction); snapshots read all of them.
+// Slots outlive their threads so nothing counted is lost.
+class ScanStatsRegistry
+{
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> values[ScanStats::FIELD_COUNT] = {};
+    };
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Slot>> slots;
+
+    static ScanStatsRegistry &instance()
+    {
+        static ScanStatsRegistry registry;
+        return registry;
+    }
+
+    static Slot *registerThread()
+    {
+        ScanStatsRegistry &registry = instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.slots.push_back(std::make_unique<Slot>());
+        return registry.slots.back().get();
+    }
+
+public:
+    static FORCE_INLINE void add(size_t field, uint64_t n) noexcept
+    {
+        thread_local Slot *slot = registerThread();
+        std::atomic<uint64_t> &value = slot->values[field];
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    static ScanStats snapshot()
+    {
+        ScanStatsRegistry &registry = instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        ScanStats total;
+        for (const auto &slot : registry.slots)
+            for (size_t f = 0; f < ScanStats::FIELD_COUNT; ++f)
+                total.values[f] += slot->values[f].load(std::memory_order_relaxed);
+        return total;
+    }
+
+    // Call while no scan is running; a concurrent increment may undo the reset of its field.
+    static void reset()
+    {
+        ScanStatsRegistry &registry = instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const auto &slot : registry.slots)
+            for (auto &value : slot->values)
+                value.store(0, std::memory_order_relaxed);
+    }
+};
+
+// Adds the lifetime of the enclosing scope, in nanoseconds, to a field.
+class ScanStatsTimer
+{
+private:
+    size_t field;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+public:
+    explicit ScanStatsTimer(size_t f) noexcept : field(f) {}
+    ~ScanStatsTimer()
+    {
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        ScanStatsRegistry::add(field, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+};
+
+#define PHONE_STAT_ADD(field, n) ScanStatsRegistry::add((field), (n))
+#define PHONE_STAT_TIMER(field) ScanStatsTimer phoneStatsTimer((field))
+
+inline ScanStats phoneScanStats() { return ScanStatsRegistry::snapshot(); }
+inline void resetPhoneScanStats() { ScanStatsRegistry::reset(); }
+#else
+#define PHONE_STAT_ADD(field, n) ((void)0)
+#define PHONE_STAT_TIMER(field) ((void)0)
+
+inline ScanStats phoneScanStats() { return ScanStats(); }
+inline void resetPhoneScanStats() {}
+#endif
+
+#define PHONE_STAT_CANDIDATE(pass) PHONE_STAT_ADD(ScanStats::candidates(pass), 1)
+#define PHONE_STAT_ACCEPT(pass) PHONE_STAT_ADD(ScanStats::accepted(pass), 1)
+#define PHONE_STAT_REJECT(pass, reason) PHONE_STAT_ADD(ScanStats::rejected((pass), (reason)), 1)
+
+// ============================================================================
+// SIMD PREFILTER
+// ============================================================================
+
+// Finds the next byte that can start a phone number (digit, '+' or '(') so the
+// scanner skips digit-free text at close to memory bandwidth. The widest
+// instruction set supported by the running CPU is picked once at startup.
+class CandidatePrefilter
+{
+public:
+    enum class Level
+    {
+        SCALAR,
+        SSE2,
+        AVX2
+    };
+
+    using FindFn = size_t (*)(const char *data, size_t from, size_t to) noexcept;
+
+    static size_t findScalar(const char *data, size_t from, size_t to) noexcept
+    {
+        while (from < to && !CharacterClassifier::isCandidateStart(data[from]))
+            ++from;
+        return from;
+    }
+
+#if PHONE_DETECTOR_X86
+    __attribute__((target("sse2"))) static size_t findSSE2(const char *data, size_t from, size_t to) noexcept
+    {
+        const __m128i zero = _mm_set1_epi8('0');
+        const __m128i nine = _mm_set1_epi8(9);
+        const __m128i plus = _mm_set1_epi8('+');
+        const __m128i open = _mm_set1_epi8('(');
+
+        while (from + 16 <= to)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + from));
+            const __m128i offset = _mm_sub_epi8(v, zero);
+            const __m128i digit = _mm_cmpeq_epi8(_mm_min_epu8(offset, nine), offset);
+            const __m128i hit = _mm_or_si128(digit, _mm_or_si128(_mm_cmpeq_epi8(v, plus), _mm_cmpeq_epi8(v, open)));
+            const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hit));
+            if (mask != 0)
+                return from + __builtin_ctz(mask);
+            from += 16;
+        }
+        return findScalar(data, from, to);
+    }
+
+    __attribute__((target("avx2"))) static size_t findAVX2(const char *data, size_t from, size_t to) noexcept
+    {
+        const __m256i zero = _mm256_set1_epi8('0');
+        const __m256i nine = _mm256_set1_epi8(9);
+        const __m256i plus = _mm256_set1_epi8('+');
+        const __m256i open = _mm256_set1_epi8('(');
+
+        while (from + 32 <= to)
+        {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + from));
+            const __m256i offset = _mm256_sub_epi8(v, zero);
+            const __m256i digit = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, nine), offset);
+            const __m256i hit = _mm256_or_si256(digit, _mm256_or_si256(_mm256_cmpeq_epi8(v, plus), _mm256_cmpeq_epi8(v, open)));
+            const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hit));
+            if (mask != 0)
+                return from + __builtin_ctz(mask);
+            from += 32;
+        }
+        return findSSE2(data, from, to);
+    }
+#endif
+
+    static bool supports(Level level) noexcept
+    {
+        switch (level)
+        {
+        case Level::SCALAR:
+            return true;
+#if PHONE_DETECTOR_X86
+        case Level::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case Level::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+        }
+    }
+
+    static FindFn finder(Level level) noexcept
+    {
+        switch (level)
+        {
+#if PHONE_DETECTOR_X86
+        case Level::SSE2:
+            return &findSSE2;
+        case Level::AVX2:
+            return &findAVX2;
+#endif
+        default:
+            return &findScalar;
+        }
+    }
+
+    static Level bestLevel() noexcept
+    {
+        if (supports(Level::AVX2))
+            return Level::AVX2;
+        if (supports(Level::SSE2))
+            return Level::SSE2;
+        return Level::SCALAR;
+    }
+
+    static FORCE_INLINE size_t find(const char *data, size_t from, size_t to) noexcept
+    {
+        static const FindFn best = finder(bestLevel());
+        return best(data, from, to);
+    }
+};
+
+// ============================================================================
+// UTILITY FUNCTIONS
+// ============================================================================
+
+FORCE_INLINE std::string extractDigits(const std::string &str) noexcept
+{
+    std::string digits;
+    digits.reserve(str.length());
+    for (char c : str)
+    {
+        if (CharacterClassifier::isDigit(c))
+            digits += c;
+    }
+    return digits;
+}
+
+// Inline digit buffer; no supported format (E.164 included) exceeds 15 digits.
+struct NormalizedDigits
+{
+    static constexpr size_t CAPACITY = 15;
+
+    char digits[CAPACITY];
+    uint8_t length = 0;
+
+    std::string_view view() const noexcept { return std::string_view(digits, length); }
+    std::string str() const { return std::string(digits, length); }
+};
+
+FORCE_INLINE NormalizedDigits extractDigits(std::string_view str) noexcept
+{
+    NormalizedDigits out;
+    for (char c : str)
+    {
+        if (CharacterClassifier::isDigit(c) && out.length < NormalizedDigits::CAPACITY)
+            out.digits[out.length++] = c;
+    }
+    return out;
+}
+
+// Bytes at the start of a match that are not part of its number: the "00" of
+// INTERNATIONAL_00, so that "0044 20 …" normalizes like "+44 20 …".
+constexpr size_t dialPrefixLength(PhoneType type) noexcept
+{
+    return type == PhoneType::INTERNATIONAL_00 ? 2 : 0;
+}
+
+// Non-owning match: `value` points into the scanned buffer, which must outlive it.
+struct PhoneMatchView
+{
+    PhoneType type = PhoneType::UNKNOWN;
+    size_t position = 0;
+    std::string_view value;
+
+    size_t length() const noexcept { return value.length(); }
+    NormalizedDigits normalized() const noexcept { return extractDigits(value.substr(dialPrefixLength(type))); }
+};
+
+// Owning compatibility form. The parenthesized format always reports "(NXX) "
+// regardless of the separator that followed the area code in the source text.
+inline PhoneMatch toPhoneMatch(const PhoneMatchView &view)
+{
+    std::string value(view.value);
+    if (view.type == PhoneType::FORMATTED_DOMESTIC && value[0] == '(')
+        value[5] = ' ';
+    return PhoneMatch(view.type, std::move(value), view.normalized().str(), view.position);
+}
+
+// Same, with the strings in `resource`.
+inline PmrPhoneMatch toPhoneMatch(const PhoneMatchView &view, std::pmr::memory_resource *resource)
+{
+    PmrPhoneMatch match(view.type, view.value, view.normalized().view(), view.position, resource);
+    if (view.type == PhoneType::FORMATTED_DOMESTIC && match.value[0] == '(')
+        match.value[5] = ' ';
+    return match;
+}
+
+// Flat result of a batch scan: the matches of document d are
+// matches[offsets[d], offsets[d + 1]), with positions relative to that document.
+// clear() keeps the capacity, so a reused batch stops allocating once warm.
+struct PhoneMatchBatch
+{
+    std::vector<PhoneMatchView> matches;
+    std::vector<size_t> offsets{0};
+
+    size_t documentCount() const noexcept { return offsets.size() - 1; }
+    size_t matchCount(size_t doc) const noexcept { return offsets[doc + 1] - offsets[doc]; }
+    const PhoneMatchView *begin(size_t doc) const noexcept { return matches.data() + offsets[doc]; }
+    const PhoneMatchView *end(size_t doc) const noexcept { return matches.data() + offsets[doc + 1]; }
+
+    void clear() noexcept
+    {
+        matches.clear();
+        offsets.resize(1);
+    }
+};
+
+// Columnar batch result: match i is entry i of every column, in document
+// order. The digits column uses Arrow's variable-length string layout: the
+// normalized digits of match i are digits[digitOffsets[i], digitOffsets[i + 1])
+// and digitOffsets starts at 0, so digits and digitOffsets can back an Arrow
+// utf8 array (int32 offsets, no nulls) without copying. The other columns map
+// to uint32, uint32, uint8 and uint8 arrays; `type` holds PhoneType values.
+// clear() keeps the capacity, so a reused result stops allocating once warm.
+struct PhoneMatchColumns
+{
+    std::vector<uint32_t> document;
+    std::vector<uint32_t> position;
+    std::vector<uint8_t> length;
+    std::vector<uint8_t> type;
+    std::vector<char> digits;
+    std::vector<int32_t> digitOffsets{0};
+
+    size_t size() const noexcept { return position.size(); }
+    PhoneType typeOf(size_t i) const noexcept { return static_cast<PhoneType>(type[i]); }
+    std::string_view digitsOf(size_t i) const noexcept
+    {
+        return std::string_view(digits.data() + digitOffsets[i], static_cast<size_t>(digitOffsets[i + 1] - digitOffsets[i]));
+    }
+
+    void clear() noexcept
+    {
+        document.clear();
+        position.clear();
+        length.clear();
+        type.clear();
+        digits.clear();
+        digitOffsets.resize(1);
+    }
+};
+
+// Per-thread scratch state reused across batch calls on the same thread.
+class ScannerContext
+{
+public:
+    PhoneMatchBatch batch;
+
+    static ScannerContext &local() noexcept
+    {
+        thread_local ScannerContext context;
+        return context;
+    }
+};
+
+// ============================================================================
+// ARENA
+// ============================================================================
+
+// Bump-pointer std::pmr::memory_resource for per-request results. Allocating
+// moves a cursor through the current block, deallocating does nothing, and
+// reset() rewinds to the first block in O(1) while keeping every block, so a
+// handler that resets after each batch soon stops calling the upstream
+// resource at all. Blocks start at blockSize and double as needed. Not
+// thread-safe: give each thread (or request) its own arena, and reset it only
+// when nothing allocated from it is still in use.
+class PhoneArena : public std::pmr::memory_resource
+{
+private:
+    struct Block
+    {
+        Block *next;
+        size_t size; // usable bytes after the header
+    };
+
+    static constexpr size_t HEADER = (sizeof(Block) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+    std::pmr::memory_resource *upstream;
+    size_t blockSize;
+    Block *first = nullptr;
+    Block *current = nullptr;
+    uintptr_t cursor = 0;
+    uintptr_t limit = 0;
+    size_t reserved = 0;
+
+    static char *data(Block *block) noexcept { return reinterpret_cast<char *>(block) + HEADER; }
+
+    void enter(Block *block) noexcept
+    {
+        current = block;
+        cursor = reinterpret_cast<uintptr_t>(data(block));
+        limit = cursor + block->size;
+    }
+
+    // Moves to the next kept block that fits, or links a new one after the
+    // current block. A kept block too small for this request stays in the
+    // chain for later resets.
+    void *allocateSlow(size_t bytes, size_t alignment)
+    {
+        const size_t needed = bytes + alignment;
+        while (current && current->next)
+        {
+            enter(current->next);
+            const uintptr_t p = (cursor + alignment - 1) & ~(uintptr_t(alignment) - 1);
+            if (p - cursor + bytes <= limit - cursor)
+            {
+                cursor = p + bytes;
+                return reinterpret_cast<void *>(p);
+            }
+        }
+        size_t size = current ? current->size * 2 : blockSize;
+        while (size < needed)
+            size *= 2;
+        Block *block = static_cast<Block *>(upstream->allocate(HEADER + size, alignof(std::max_align_t)));
+        block->next = nullptr;
+        block->size = size;
+        reserved += size;
+        if (current)
+            current->next = block;
+        else
+            first = block;
+        enter(block);
+        const uintptr_t p = (cursor + alignment - 1) & ~(uintptr_t(alignment) - 1);
+        cursor = p + bytes;
+        return reinterpret_cast<void *>(p);
+    }
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        const uintptr_t p = (cursor + alignment - 1) & ~(uintptr_t(alignment) - 1);
+        if (LIKELY(current && p - cursor + bytes <= limit - cursor))
+        {
+            cursor = p + bytes;
+            return reinterpret_cast<void *>(p);
+        }
+        return allocateSlow(bytes, alignment);
+    }
+
+    void do_deallocate(void *, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    explicit PhoneArena(size_t blockBytes = DEFAULT_BLOCK_SIZE,
+                        std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : upstream(resource), blockSize(std::max<size_t>(blockBytes, 256)) {}
+
+    PhoneArena(const PhoneArena &) = delete;
+    PhoneArena &operator=(const PhoneArena &) = delete;
+
+    ~PhoneArena() override { release(); }
+
+    // Everything allocated so far becomes free; the blocks are kept.
+    void reset() noexcept
+    {
+        if (first)
+            enter(first);
+    }
+
+    // Returns every block to the upstream resource.
+    void release() noexcept
+    {
+        for (Block *block = first; block;)
+        {
+            Block *next = block->next;
+            upstream->deallocate(block, HEADER + block->size, alignof(std::max_align_t));
+            block = next;
+        }
+        first = current = nullptr;
+        cursor = limit = 0;
+        reserved = 0;
+    }
+
+    // Bytes obtained from upstream, excluding block headers.
+    size_t bytesReserved() const noexcept { return reserved; }
+};
+
+// ============================================================================
+// PHONE KEYS
+// ============================================================================
+
+// Up to 15 normalized digits packed into 64 bits: the digit count in the top
+// four bits, then one digit per nibble from the most significant end. Keys of
+// equal length compare like their digit strings. The all-zero key is invalid.
+struct PhoneKey
+{
+    static constexpr size_t MAX_DIGITS = 15;
+
+    uint64_t bits = 0;
+
+    // Returns the invalid key unless digits holds 1 to 15 ASCII digits only.
+    static PhoneKey fromDigits(std::string_view digits) noexcept
+    {
+        PhoneKey key;
+        if (digits.empty() || digits.length() > MAX_DIGITS)
+            return key;
+        uint64_t packed = static_cast<uint64_t>(digits.length()) << 60;
+        for (size_t i = 0; i < digits.length(); ++i)
+        {
+            if (!CharacterClassifier::isDigit(digits[i]))
+                return key;
+            packed |= static_cast<uint64_t>(digits[i] - '0') << (56 - 4 * i);
+        }
+        key.bits = packed;
+        return key;
+    }
+
+    // Keys the digits of formatted text, e.g. "+1 (234) 567-8900".
+    static PhoneKey fromText(std::string_view text) noexcept { return fromDigits(extractDigits(text).view()); }
+    static PhoneKey fromMatch(const PhoneMatchView &match) noexcept { return fromDigits(match.normalized().view()); }
+
+    bool valid() const noexcept { return bits != 0; }
+    size_t length() const noexcept { return static_cast<size_t>(bits >> 60); }
+
+    NormalizedDigits digits() const noexcept
+    {
+        NormalizedDigits out;
+        out.length = static_cast<uint8_t>(length());
+        for (size_t i = 0; i < out.length; ++i)
+            out.digits[i] = static_cast<char>('0' + ((bits >> (56 - 4 * i)) & 0xF));
+        return out;
+    }
+
+    friend bool operator==(PhoneKey a, PhoneKey b) noexcept { return a.bits == b.bits; }
+    friend bool operator!=(PhoneKey a, PhoneKey b) noexcept { return a.bits != b.bits; }
+    friend bool operator<(PhoneKey a, PhoneKey b) noexcept { return a.bits < b.bits; }
+};
+
+// ============================================================================
+// KNOWN NUMBER INDEX
+// ============================================================================
+
+// Read-only set of PhoneKeys in an open-addressing table (linear probing, at
+// most half full, 0 marks an empty slot). The in-memory image is also the file
+// format: a three-word header followed by the slots, in native byte order, so
+// a saved index is mapped in place rather than parsed.
+class PhoneKeyIndex
+{
+private:
+    static constexpr uint64_t MAGIC = 0x3158444959454B50ull; // "PKEYIDX1"
+    static constexpr size_t HEADER_WORDS = 3;                // magic, slot count, key count
+    static constexpr uint64_t HASH_MULTIPLIER = 0x9E3779B97F4A7C15ull;
+
+    std::vector<uint64_t> storage; // image of a built or read() index
+    void *mapping = nullptr;       // image of a mapped index
+    size_t mappingSize = 0;
+
+    const uint64_t *slots = nullptr;
+    uint64_t mask = 0;
+    unsigned shift = 64;
+    size_t keyCount = 0;
+
+    FORCE_INLINE uint64_t home(uint64_t bits) const noexcept { return (bits * HASH_MULTIPLIER) >> shift; }
+
+    // Points the lookup fields at an image after checking its header and size.
+    bool attach(const uint64_t *image, size_t bytes) noexcept
+    {
+        if (bytes < HEADER_WORDS * sizeof(uint64_t) || image[0] != MAGIC)
+            return false;
+        // slotCount is bounded before it is multiplied, so a hostile header cannot wrap the size check.
+        const uint64_t slotCount = image[1];
+        if (slotCount < 2 || (slotCount & (slotCount - 1)) != 0 || image[2] >= slotCount ||
+            slotCount > bytes / sizeof(uint64_t) - HEADER_WORDS || bytes != (HEADER_WORDS + slotCount) * sizeof(uint64_t))
+            return false;
+
+        unsigned log2 = 0;
+        while ((uint64_t(1) << log2) < slotCount)
+            ++log2;
+        slots = image + HEADER_WORDS;
+        mask = slotCount - 1;
+        shift = 64 - log2;
+        keyCount = static_cast<size_t>(image[2]);
+        return true;
+    }
+
+    void release() noexcept
+    {
+#if PHONE_DETECTOR_POSIX
+        if (mapping)
+            ::munmap(mapping, mappingSize);
+#endif
+        mapping = nullptr;
+        mappingSize = 0;
+        storage.clear();
+        slots = nullptr;
+        mask = 0;
+        shift = 64;
+        keyCount = 0;
+    }
+
+public:
+    PhoneKeyIndex() = default;
+    ~PhoneKeyIndex() { release(); }
+
+    PhoneKeyIndex(PhoneKeyIndex &&other) noexcept { *this = std::move(other); }
+    PhoneKeyIndex &operator=(PhoneKeyIndex &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            storage = std::move(other.storage);
+            mapping = std::exchange(other.mapping, nullptr);
+            mappingSize = std::exchange(other.mappingSize, 0);
+            slots = std::exchange(other.slots, nullptr);
+            mask = std::exchange(other.mask, 0);
+            shift = std::exchange(other.shift, 64);
+            keyCount = std::exchange(other.keyCount, 0);
+        }
+        return *this;
+    }
+    PhoneKeyIndex(const PhoneKeyIndex &) = delete;
+    PhoneKeyIndex &operator=(const PhoneKeyIndex &) = delete;
+
+    // Invalid keys are skipped and duplicates stored once.
+    static PhoneKeyIndex build(const PhoneKey *keys, size_t count)
+    {
+        uint64_t slotCount = 16;
+        while (slotCount < 2 * count)
+            slotCount <<= 1;
+
+        PhoneKeyIndex index;
+        index.storage.assign(HEADER_WORDS + slotCount, 0);
+        index.storage[0] = MAGIC;
+        index.storage[1] = slotCount;
+        index.attach(index.storage.data(), index.storage.size() * sizeof(uint64_t));
+
+        uint64_t *table = index.storage.data() + HEADER_WORDS;
+        size_t stored = 0;
+        for (size_t k = 0; k < count; ++k)
+        {
+            const uint64_t bits = keys[k].bits;
+            if (bits == 0)
+                continue;
+            uint64_t slot = index.home(bits);
+            while (table[slot] != 0 && table[slot] != bits)
+                slot = (slot + 1) & index.mask;
+            if (table[slot] == 0)
+            {
+                table[slot] = bits;
+                ++stored;
+            }
+        }
+        index.storage[2] = stored;
+        index.keyCount = stored;
+        return index;
+    }
+
+    static PhoneKeyIndex build(const std::vector<PhoneKey> &keys) { return build(keys.data(), keys.size()); }
+
+    bool save(const std::string &path) const
+    {
+        if (!slots)
+            return false;
+        std::FILE *file = std::fopen(path.c_str(), "wb");
+        if (!file)
+            return false;
+        const uint64_t header[HEADER_WORDS] = {MAGIC, mask + 1, keyCount};
+        bool ok = std::fwrite(header, sizeof(uint64_t), HEADER_WORDS, file) == HEADER_WORDS &&
+                  std::fwrite(slots, sizeof(uint64_t), mask + 1, file) == mask + 1;
+        return std::fclose(file) == 0 && ok;
+    }
+
+    // Maps a saved index read-only (or reads it where mmap is unavailable).
+    // Returns false and leaves the index empty if the file is missing or malformed.
+    bool load(const std::string &path)
+    {
+        release();
+#if PHONE_DETECTOR_POSIX
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void *map = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            if (map != MAP_FAILED)
+            {
+                mapping = map;
+                mappingSize = static_cast<size_t>(st.st_size);
+            }
+        }
+        ::close(fd);
+        if (mapping && attach(static_cast<const uint64_t *>(mapping), mappingSize))
+            return true;
+#else
+        std::FILE *file = std::fopen(path.c_str(), "rb");
+        if (!file)
+            return false;
+        std::fseek(file, 0, SEEK_END);
+        const long bytes = std::ftell(file);
+        std::fseek(file, 0, SEEK_SET);
+        if (bytes > 0 && bytes % sizeof(uint64_t) == 0)
+        {
+            storage.resize(static_cast<size_t>(bytes) / sizeof(uint64_t));
+            if (std::fread(storage.data(), sizeof(uint64_t), storage.size(), file) != storage.size())
+                storage.clear();
+        }
+        std::fclose(file);
+        if (!storage.empty() && attach(storage.data(), storage.size() * sizeof(uint64_t)))
+            return true;
+#endif
+        release();
+        return false;
+    }
+
+    FORCE_INLINE bool contains(PhoneKey key) const noexcept
+    {
+        if (UNLIKELY(key.bits == 0 || !slots))
+            return false;
+        uint64_t slot = home(key.bits);
+        for (uint64_t probes = 0; probes <= mask; ++probes)
+        {
+            const uint64_t stored = slots[slot];
+            if (stored == key.bits)
+                return true;
+            if (stored == 0)
+                return false;
+            slot = (slot + 1) & mask;
+        }
+        return false;
+    }
+
+    // Bit i of bitmap ((count + 63) / 64 words) is set when keys[i] is in the
+    // index. Slots are prefetched a few keys ahead to overlap the cache misses
+    // of a large table.
+    void containsMany(const PhoneKey *keys, size_t count, uint64_t *bitmap) const noexcept
+    {
+        static constexpr size_t PREFETCH_DISTANCE = 8;
+        for (size_t word = 0; word * 64 < count; ++word)
+            bitmap[word] = 0;
+        if (!slots)
+            return;
+        for (size_t i = 0; i < count; ++i)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            if (i + PREFETCH_DISTANCE < count)
+                __builtin_prefetch(slots + home(keys[i + PREFETCH_DISTANCE].bits));
+#endif
+            bitmap[i / 64] |= static_cast<uint64_t>(contains(keys[i])) << (i % 64);
+        }
+    }
+
+    bool empty() const noexcept { return keyCount == 0; }
+    size_t size() const noexcept { return keyCount; }
+    size_t slotCount() const noexcept { return slots ? static_cast<size_t>(mask + 1) : 0; }
+    size_t memoryBytes() const noexcept { return slots ? (HEADER_WORDS + mask + 1) * sizeof(uint64_t) : 0; }
+    bool isMapped() const noexcept { return mapping != nullptr; }
+};
+
+// A match tagged with its key and whether the key is in a PhoneKeyIndex.
+struct TaggedPhoneMatch
+{
+    PhoneMatchView match;
+    PhoneKey key;
+    bool known = false;
+};
+
+// ============================================================================
+// DEDUPLICATION
+// ============================================================================
+
+// Where a number was seen: document index as assigned by the caller, and byte
+// offset in that document. Ordered by document, then position.
+struct PhoneOccurrence
+{
+    uint64_t document = 0;
+    size_t position = 0;
+
+    friend bool operator<(const PhoneOccurrence &a, const PhoneOccurrence &b) noexcept
+    {
+        return a.document != b.document ? a.document < b.document : a.position < b.position;
+    }
+};
+
+// One entry per distinct normalized number. `type` is the format of the first
+// occurrence.
+struct UniquePhone
+{
+    PhoneKey key;
+    PhoneType type = PhoneType::UNKNOWN;
+    uint64_t count = 0;
+    PhoneOccurrence first;
+};
+
+// Approximate distinct counter (HyperLogLog, 2^14 registers, about 0.8%
+// standard error) for corpora whose distinct numbers do not fit the bound.
+class DistinctEstimator
+{
+private:
+    static constexpr unsigned PRECISION = 14;
+    static constexpr size_t REGISTERS = size_t(1) << PRECISION;
+
+    std::vector<uint8_t> registers = std::vector<uint8_t>(REGISTERS, 0);
+
+public:
+    // splitmix64 finalizer: PhoneKey bits are far from uniform.
+    static FORCE_INLINE uint64_t mix(uint64_t x) noexcept
+    {
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ull;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    FORCE_INLINE void add(PhoneKey key) noexcept
+    {
+        const uint64_t hash = mix(key.bits);
+        const size_t index = static_cast<size_t>(hash >> (64 - PRECISION));
+        const uint64_t rest = (hash << PRECISION) | (uint64_t(1) << (PRECISION - 1));
+        uint8_t rank = 1;
+        for (uint64_t bit = uint64_t(1) << 63; (rest & bit) == 0; bit >>= 1)
+            ++rank;
+        registers[index] = std::max(registers[index], rank);
+    }
+
+    void merge(const DistinctEstimator &other) noexcept
+    {
+        for (size_t i = 0; i < REGISTERS; ++i)
+            registers[i] = std::max(registers[i], other.registers[i]);
+    }
+
+    double estimate() const noexcept
+    {
+        const double m = static_cast<double>(REGISTERS);
+        double sum = 0;
+        size_t zeros = 0;
+        for (uint8_t r : registers)
+        {
+            sum += 1.0 / static_cast<double>(uint64_t(1) << r);
+            zeros += r == 0;
+        }
+        const double raw = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+        if (raw <= 2.5 * m && zeros != 0)
+            return m * std::log(m / static_cast<double>(zeros)); // linear counting for small sets
+        return raw;
+    }
+
+    void clear() noexcept { std::fill(registers.begin(), registers.end(), uint8_t(0)); }
+};
+
+// Single-threaded deduplicating tally keyed on the normalized digits. Holds at
+// most maxEntries distinct numbers; occurrences of further new numbers are
+// only counted as dropped (and still reach the distinct estimator, if on).
+// Use one per thread and merge() them, or share a ConcurrentPhoneAggregator.
+class PhoneTally
+{
+    friend class ConcurrentPhoneAggregator;
+
+private:
+    struct Entry
+    {
+        PhoneType type;
+        uint64_t count;
+        PhoneOccurrence first;
+    };
+
+    std::unordered_map<uint64_t, Entry> entries;
+    std::unique_ptr<DistinctEstimator> estimator;
+    size_t maxEntries;
+    uint64_t occurrences = 0;
+    uint64_t dropped = 0;
+
+    void add(PhoneKey key, PhoneType type, uint64_t count, const PhoneOccurrence &first)
+    {
+        occurrences += count;
+        auto it = entries.find(key.bits);
+        if (it != entries.end())
+        {
+            Entry &entry = it->second;
+            entry.count += count;
+            if (first < entry.first)
+            {
+                entry.first = first;
+                entry.type = type;
+            }
+        }
+        else if (entries.size() < maxEntries)
+            entries.emplace(key.bits, Entry{type, count, first});
+        else
+            dropped += count;
+    }
+
+public:
+    explicit PhoneTally(size_t maxDistinct = SIZE_MAX, bool estimateDistinct = false)
+        : estimator(estimateDistinct ? std::make_unique<DistinctEstimator>() : nullptr), maxEntries(maxDistinct) {}
+
+    void add(PhoneKey key, PhoneType type, uint64_t document, size_t position)
+    {
+        if (!key.valid())
+            return;
+        if (estimator)
+            estimator->add(key);
+        add(key, type, 1, PhoneOccurrence{document, position});
+    }
+
+    void add(const PhoneMatchView &match, uint64_t document)
+    {
+        add(PhoneKey::fromMatch(match), match.type, document, match.position);
+    }
+
+    // Scans text with scanner and adds every match.
+    template <typename Scanner>
+    void addDocument(const Scanner &scanner, std::string_view text, uint64_t document)
+    {
+        scanner.scan(text, [&](const PhoneMatchView &match)
+                     { add(match, document); });
+    }
+
+    // Folds in another partial result. Counts add up and the earlier first
+    // occurrence wins, so merging is order-independent within the bound.
+    void merge(const PhoneTally &other)
+    {
+        for (const auto &[bits, entry] : other.entries)
+            add(PhoneKey{bits}, entry.type, entry.count, entry.first);
+        occurrences += other.dropped;
+        dropped += other.dropped;
+        if (estimator && other.estimator)
+            estimator->merge(*other.estimator);
+    }
+
+    // Distinct numbers, ordered by first occurrence.
+    std::vector<UniquePhone> results() const
+    {
+        std::vector<UniquePhone> out;
+        out.reserve(entries.size());
+        for (const auto &[bits, entry] : entries)
+            out.push_back({PhoneKey{bits}, entry.type, entry.count, entry.first});
+        std::sort(out.begin(), out.end(), [](const UniquePhone &a, const UniquePhone &b)
+                  { return a.first < b.first; });
+        return out;
+    }
+
+    size_t size() const noexcept { return entries.size(); }
+    size_t capacity() const noexcept { return maxEntries; }
+    uint64_t totalOccurrences() const noexcept { return occurrences; }
+    uint64_t droppedOccurrences() const noexcept { return dropped; }
+    // Exact while nothing was dropped; otherwise the estimate, or a lower bound without one.
+    double distinctCount() const noexcept
+    {
+        if (dropped == 0 || !estimator)
+            return static_cast<double>(entries.size());
+        return std::max(estimator->estimate(), static_cast<double>(entries.size()));
+    }
+    const DistinctEstimator *distinctEstimator() const noexcept { return estimator.get(); }
+
+    void clear() noexcept
+    {
+        entries.clear();
+        occurrences = 0;
+        dropped = 0;
+        if (estimator)
+            estimator->clear();
+    }
+};
+
+// PhoneTally split into independently locked shards by key hash, for many
+// scanner threads adding to one result. Each shard holds at most
+// maxDistinct / shards numbers.
+class ConcurrentPhoneAggregator
+{
+private:
+    struct alignas(64) Shard
+    {
+        std::mutex mutex;
+        PhoneTally tally;
+
+        Shard(size_t maxDistinct, bool estimateDistinct) : tally(maxDistinct, estimateDistinct) {}
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    Shard &shardFor(PhoneKey key) noexcept
+    {
+        return *shards[DistinctEstimator::mix(key.bits) % shards.size()];
+    }
+
+    template <typename Fn>
+    auto combined(Fn &&fn) const
+    {
+        PhoneTally total(SIZE_MAX, shards[0]->tally.distinctEstimator() != nullptr);
+        for (const auto &shard : shards)
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            total.merge(shard->tally);
+        }
+        return fn(total);
+    }
+
+public:
+    static constexpr size_t DEFAULT_SHARDS = 64;
+
+    explicit ConcurrentPhoneAggregator(size_t maxDistinct = SIZE_MAX, bool estimateDistinct = false,
+                                       size_t shardCount = DEFAULT_SHARDS)
+    {
+        shardCount = std::max<size_t>(1, shardCount);
+        const size_t perShard = maxDistinct == SIZE_MAX ? SIZE_MAX : (maxDistinct + shardCount - 1) / shardCount;
+        for (size_t s = 0; s < shardCount; ++s)
+            shards.push_back(std::make_unique<Shard>(perShard, estimateDistinct));
+    }
+
+    void add(PhoneKey key, PhoneType type, uint64_t document, size_t position)
+    {
+        Shard &shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.tally.add(key, type, document, position);
+    }
+
+    void add(const PhoneMatchView &match, uint64_t document)
+    {
+        add(PhoneKey::fromMatch(match), match.type, document, match.position);
+    }
+
+    template <typename Scanner>
+    void addDocument(const Scanner &scanner, std::string_view text, uint64_t document)
+    {
+        scanner.scan(text, [&](const PhoneMatchView &match)
+                     { add(match, document); });
+    }
+
+    // Folds in a thread's PhoneTally, one shard lock per entry.
+    void merge(const PhoneTally &partial)
+    {
+        for (const auto &[bits, entry] : partial.entries)
+        {
+            Shard &shard = shardFor(PhoneKey{bits});
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.tally.add(PhoneKey{bits}, entry.type, entry.count, entry.first);
+        }
+
+        Shard &shard = *shards[0];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.tally.occurrences += partial.dropped;
+        shard.tally.dropped += partial.dropped;
+        if (shard.tally.estimator && partial.estimator)
+            shard.tally.estimator->merge(*partial.estimator);
+    }
+
+    std::vector<UniquePhone> results() const
+    {
+        return combined([](const PhoneTally &total)
+                        { return total.results(); });
+    }
+
+    size_t size() const
+    {
+        size_t total = 0;
+        for (const auto &shard : shards)
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            total += shard->tally.size();
+        }
+        return total;
+    }
+
+    double distinctCount() const
+    {
+        return combined([](const PhoneTally &total)
+                        { return total.distinctCount(); });
+    }
+};
+
+// ============================================================================
+// REDACTION
+// ============================================================================
+
+enum class RedactionPolicy
+{
+    FULL,              // (234) 567-8900 -> **************
+    KEEP_LAST_4,       // (234) 567-8900 -> (***) ***-8900
+    FORMAT_PRESERVING, // (234) 567-8900 -> (***) ***-****
+};
+
+// Writes the masked form of in[0, length) to out, which may equal in. The
+// length never changes, so masking can be done in place.
+FORCE_INLINE void maskPhone(const char *in, char *out, size_t length, RedactionPolicy policy, char mask) noexcept
+{
+    size_t digitsLeft = 0;
+    if (policy == RedactionPolicy::KEEP_LAST_4)
+        for (size_t i = 0; i < length; ++i)
+            digitsLeft += CharacterClassifier::isDigit(in[i]);
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        const char c = in[i];
+        if (policy == RedactionPolicy::FULL)
+            out[i] = mask;
+        else if (!CharacterClassifier::isDigit(c))
+            out[i] = c;
+        else
+            out[i] = (policy == RedactionPolicy::KEEP_LAST_4 && digitsLeft-- <= 4) ? c : mask;
+    }
+}
+
+// ============================================================================
+// MATCH SINKS (for PhoneScanner::scan)
+// ============================================================================
+
+// Returned by scan() visitors; a visitor returning void always continues.
+enum class ScanControl
+{
+    CONTINUE,
+    STOP
+};
+
+struct ContainsSink
+{
+    bool found = false;
+
+    ScanControl operator()(const PhoneMatchView &) noexcept
+    {
+        found = true;
+        return ScanControl::STOP;
+    }
+};
+
+struct CountSink
+{
+    size_t count = 0;
+
+    void operator()(const PhoneMatchView &) noexcept { ++count; }
+};
+
+// Keeps the first `limit` matches in a caller-provided array.
+struct FirstNSink
+{
+    PhoneMatchView *out;
+    size_t limit;
+    size_t count = 0;
+
+    FirstNSink(PhoneMatchView *output, size_t n) noexcept : out(output), limit(n) {}
+
+    ScanControl operator()(const PhoneMatchView &match) noexcept
+    {
+        if (count < limit)
+            out[count++] = match;
+        return count < limit ? ScanControl::CONTINUE : ScanControl::STOP;
+    }
+};
+
+// Limits for latency-bound callers (scan/extractViews with ScanOptions). The
+// byte limit counts match start positions, so a match that starts before it
+// is still reported whole. The deadline is read once per checkInterval bytes,
+// never per match; a scan that finishes inside one interval does not read
+// the clock at all.
+struct ScanOptions
+{
+    using Clock = std::chrono::steady_clock;
+
+    size_t maxMatches = SIZE_MAX;
+    size_t maxBytes = SIZE_MAX;
+    Clock::time_point deadline = Clock::time_point::max();
+    size_t checkInterval = 64 * 1024;
+
+    static ScanOptions within(Clock::duration budget) noexcept
+    {
+        ScanOptions options;
+        options.deadline = Clock::now() + budget;
+        return options;
+    }
+};
+
+// Why a limited scan ended. Anything but COMPLETE means the matches found so
+// far are a prefix of what an unlimited scan would report.
+enum class ScanStatus
+{
+    COMPLETE,
+    MATCH_LIMIT,
+    BYTE_LIMIT,
+    DEADLINE,
+    STOPPED,        // the visitor returned ScanControl::STOP
+    INPUT_TOO_LARGE // the text exceeds maxInputSize(); nothing scanned
+};
+
+inline const char *scanStatusName(ScanStatus status) noexcept
+{
+    switch (status)
+    {
+    case ScanStatus::COMPLETE:
+        return "complete";
+    case ScanStatus::MATCH_LIMIT:
+        return "match_limit";
+    case ScanStatus::BYTE_LIMIT:
+        return "byte_limit";
+    case ScanStatus::DEADLINE:
+        return "deadline";
+    case ScanStatus::STOPPED:
+        return "stopped";
+    case ScanStatus::INPUT_TOO_LARGE:
+        return "input_too_large";
+    }
+    return "unknown";
+}
+
+struct ScanResult
+{
+    std::vector<PhoneMatchView> matches;
+    ScanStatus status = ScanStatus::COMPLETE;
+    size_t scannedBytes = 0; // where the scan stopped; every match starting before it was reported
+
+    bool truncated() const noexcept { return status != ScanStatus::COMPLETE; }
+};
+
+// ============================================================================
+// COUNTRY CALLING CODES
+// ============================================================================
+
+// An ITU-T E.164 country calling code and the national significant number
+// lengths in use behind it (mobile and geographic; short codes excluded).
+struct CallingCodeAssignment
+{
+    uint16_t code;
+    uint8_t minNational;
+    uint8_t maxNational;
+};
+
+inline constexpr CallingCodeAssignment CALLING_CODE_ASSIGNMENTS[] = {
+    // Zone 1: North American Numbering Plan. Zone 7: Russia and Kazakhstan.
+    {1, 10, 10}, {7, 10, 10},
+    // Zone 2: Africa and the South Atlantic.
+    {20, 8, 10}, {211, 9, 9}, {212, 9, 9}, {213, 8, 9}, {216, 8, 8}, {218, 8, 9}, {220, 7, 7},
+    {221, 9, 9}, {222, 8, 8}, {223, 8, 8}, {224, 8, 9}, {225, 8, 10}, {226, 8, 8}, {227, 8, 8},
+    {228, 8, 8}, {229, 8, 10}, {230, 7, 8}, {231, 7, 9}, {232, 8, 8}, {233, 9, 9}, {234, 7, 10},
+    {235, 8, 8}, {236, 8, 8}, {237, 8, 9}, {238, 7, 7}, {239, 7, 7}, {240, 9, 9}, {241, 7, 8},
+    {242, 9, 9}, {243, 7, 9}, {244, 9, 9}, {245, 7, 9}, {246, 7, 7}, {247, 4, 5}, {248, 7, 7},
+    {249, 9, 9}, {250, 9, 9}, {251, 9, 9}, {252, 7, 9}, {253, 8, 8}, {254, 7, 10}, {255, 9, 9},
+    {256, 9, 9}, {257, 8, 8}, {258, 8, 9}, {260, 9, 9}, {261, 9, 9}, {262, 9, 9}, {263, 5, 10},
+    {264, 8, 10}, {265, 7, 9}, {266, 8, 8}, {267, 7, 8}, {268, 8, 8}, {269, 7, 7}, {27, 9, 9},
+    {290, 4, 5}, {291, 7, 7}, {297, 7, 7}, {298, 6, 6}, {299, 6, 6},
+    // Zones 3 and 4: Europe.
+    {30, 10, 10}, {31, 9, 10}, {32, 8, 9}, {33, 9, 9}, {34, 9, 9}, {350, 8, 8}, {351, 9, 9},
+    {352, 4, 11}, {353, 7, 10}, {354, 7, 9}, {355, 6, 9}, {356, 8, 8}, {357, 8, 8}, {358, 5, 12},
+    {359, 7, 9}, {36, 8, 9}, {370, 8, 8}, {371, 8, 8}, {372, 7, 10}, {373, 8, 8}, {374, 8, 8},
+    {375, 9, 10}, {376, 6, 9}, {377, 8, 9}, {378, 6, 10}, {380, 9, 9}, {381, 6, 12}, {382, 8, 9},
+    {383, 8, 9}, {385, 6, 9}, {386, 8, 8}, {387, 8, 9}, {389, 8, 8}, {39, 6, 11}, {40, 9, 9},
+    {41, 9, 9}, {420, 9, 9}, {421, 6, 9}, {423, 7, 9}, {43, 4, 13}, {44, 7, 10}, {45, 8, 8},
+    {46, 7, 10}, {47, 8, 8}, {48, 9, 9}, {49, 6, 13},
+    // Zone 5: Central and South America.
+    {500, 5, 5}, {501, 7, 7}, {502, 8, 8}, {503, 8, 8}, {504, 8, 8}, {505, 8, 8}, {506, 8, 8},
+    {507, 7, 8}, {508, 6, 6}, {509, 8, 8}, {51, 8, 9}, {52, 10, 10}, {53, 6, 8}, {54, 10, 11},
+    {55, 10, 11}, {56, 9, 9}, {57, 8, 10}, {58, 10, 10}, {590, 9, 9}, {591, 8, 8}, {592, 7, 7},
+    {593, 8, 9}, {594, 9, 9}, {595, 6, 9}, {596, 9, 9}, {597, 6, 7}, {598, 8, 8}, {599, 7, 8},
+    // Zone 6: Southeast Asia and Oceania.
+    {60, 7, 10}, {61, 9, 9}, {62, 7, 12}, {63, 8, 10}, {64, 8, 10}, {65, 8, 8}, {66, 8, 9},
+    {670, 7, 8}, {672, 6, 6}, {673, 7, 7}, {674, 7, 7}, {675, 7, 8}, {676, 5, 7}, {677, 5, 7},
+    {678, 5, 7}, {679, 7, 7}, {680, 7, 7}, {681, 6, 9}, {682, 5, 5}, {683, 4, 7}, {685, 5, 10},
+    {686, 5, 8}, {687, 6, 6}, {688, 5, 7}, {689, 6, 8}, {690, 4, 7}, {691, 7, 7}, {692, 7, 7},
+    // Zone 8: East Asia and global services.
+    {800, 8, 8}, {808, 8, 8}, {81, 9, 10}, {82, 8, 10}, {84, 9, 10}, {850, 8, 10}, {852, 8, 8},
+    {853, 8, 8}, {855, 8, 9}, {856, 8, 10}, {870, 9, 9}, {878, 10, 12}, {880, 8, 10}, {881, 9, 9},
+    {882, 7, 12}, {883, 9, 12}, {86, 9, 11}, {886, 8, 9}, {888, 8, 12},
+    // Zone 9: West, Central and South Asia and the Middle East.
+    {90, 10, 10}, {91, 10, 10}, {92, 8, 10}, {93, 9, 9}, {94, 9, 9}, {95, 7, 10}, {960, 7, 7},
+    {961, 7, 8}, {962, 8, 9}, {963, 8, 9}, {964, 8, 10}, {965, 8, 8}, {966, 8, 9}, {967, 7, 9},
+    {968, 8, 8}, {970, 8, 9}, {971, 8, 9}, {972, 8, 9}, {973, 8, 8}, {974, 8, 8}, {975, 7, 8},
+    {976, 8, 8}, {977, 8, 10}, {979, 9, 9}, {98, 10, 10}, {992, 9, 9}, {993, 8, 8}, {994, 9, 9},
+    {995, 9, 9}, {996, 9, 9}, {998, 9, 9}};
+
+// Calling codes form a prefix code of one to three digits, so their trie
+// flattens into one table indexed by the first three digits of a number.
+// Each entry packs the length of the code those digits start with (0 if
+// none is assigned) and the national lengths allowed behind it. Building it
+// also checks that no code is a prefix of another and that every allowed
+// length fits in E.164's 15 digits.
+struct CallingCodeTable
+{
+    uint16_t entries[1000] = {};
+    bool consistent = true;
+
+    static constexpr uint16_t pack(size_t codeLength, size_t minNational, size_t maxNational) noexcept
+    {
+        return static_cast<uint16_t>(codeLength | minNational << 2 | maxNational << 6);
+    }
+
+    static constexpr CallingCodeTable build() noexcept
+    {
+        CallingCodeTable table;
+        for (const CallingCodeAssignment &assignment : CALLING_CODE_ASSIGNMENTS)
+        {
+            const size_t codeLength = assignment.code < 10 ? 1 : assignment.code < 100 ? 2 : 3;
+            const size_t span = codeLength == 1 ? 100 : codeLength == 2 ? 10 : 1;
+            if (assignment.code == 0 || assignment.code > 999 || assignment.minNational > assignment.maxNational ||
+                assignment.maxNational + codeLength > 15)
+                table.consistent = false;
+            for (size_t k = assignment.code * span; k < (assignment.code + 1) * span && k < 1000; ++k)
+            {
+                if (table.entries[k] != 0)
+                    table.consistent = false;
+                table.entries[k] = pack(codeLength, assignment.minNational, assignment.maxNational);
+            }
+        }
+        return table;
+    }
+};
+
+class CallingCodes
+{
+private:
+    static constexpr CallingCodeTable TABLE = CallingCodeTable::build();
+    static_assert(TABLE.consistent, "calling codes must be prefix-free, and code plus national number at most 15 digits");
+
+    static constexpr uint16_t entry(const char *lead) noexcept
+    {
+        return TABLE.entries[(lead[0] - '0') * 100 + (lead[1] - '0') * 10 + (lead[2] - '0')];
+    }
+
+public:
+    // lead holds the first three digits after the '+' or "00".
+    static constexpr size_t codeLength(const char *lead) noexcept { return entry(lead) & 3; }
+
+    // Whether digitCount digits starting with lead (calling code included)
+    // are an assigned code followed by a national number of a length in use.
+    static constexpr bool isValidNumber(const char *lead, size_t digitCount) noexcept
+    {
+        const uint16_t packed = entry(lead);
+        const size_t codeLength = packed & 3;
+        const size_t national = digitCount - codeLength;
+        return codeLength != 0 && digitCount > codeLength && national >= ((packed >> 2) & 15) && national <= (packed >> 6);
+    }
+
+    // digits: an E.164 number without its '+' or "00", digits only.
+    static constexpr bool isValidNumber(std::string_view digits) noexcept
+    {
+        return digits.length() >= 3 && isValidNumber(digits.data(), digits.length());
+    }
+};
+
+// ============================================================================
+// VALIDATORS (Single Responsibility Principle)
+// ============================================================================
+
+// Everything the validation rules look at: how many digits a value holds and
+// what its first four digits are.
+struct DigitProfile
+{
+    size_t count = 0;
+    char lead[4] = {0, 0, 0, 0};
+
+    FORCE_INLINE void add(char digit) noexcept
+    {
+        if (count < 4)
+            lead[count] = digit;
+        ++count;
+    }
+};
+
+FORCE_INLINE DigitProfile profileDigitsScalar(std::string_view value) noexcept
+{
+    DigitProfile out;
+    for (char c : value)
+    {
+        if (CharacterClassifier::isDigit(c))
+            out.add(c);
+    }
+    return out;
+}
+
+#if PHONE_DETECTOR_X86 && defined(__SSE2__)
+// 16 bytes per step. A short tail is copied into a zeroed block first, so no
+// load reads past the end of the value.
+FORCE_INLINE DigitProfile profileDigits(std::string_view value) noexcept
+{
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    const char *data = value.data();
+    const size_t len = value.length();
+
+    DigitProfile out;
+    auto accumulate = [&](const char *block)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block));
+        const __m128i offset = _mm_sub_epi8(v, zero);
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(offset, nine), offset)));
+        for (; mask != 0 && out.count < 4; mask &= mask - 1)
+            out.lead[out.count++] = block[__builtin_ctz(mask)];
+        out.count += static_cast<size_t>(__builtin_popcount(mask));
+    };
+
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+        accumulate(data + i);
+
+    if (i < len)
+    {
+        alignas(16) char tail[16] = {};
+        std::memcpy(tail, data + i, len - i);
+        accumulate(tail);
+    }
+    return out;
+}
+#else
+FORCE_INLINE DigitProfile profileDigits(std::string_view value) noexcept
+{
+    return profileDigitsScalar(value);
+}
+#endif
+
+// Shared batch entry point of the non-virtual rules below. `bitmap` must hold
+// (count + 63) / 64 words; bit i of the result is set when values[i] is valid.
+template <typename Rule>
+class BatchValidator
+{
+public:
+    void validateMany(const std::string_view *values, size_t count, uint64_t *bitmap) const noexcept
+    {
+        const Rule &rule = static_cast<const Rule &>(*this);
+        for (size_t word = 0; word * 64 < count; ++word)
+        {
+            const std::string_view *block = values + word * 64;
+            const size_t n = std::min<size_t>(64, count - word * 64);
+            uint64_t bits = 0;
+            for (size_t i = 0; i < n; ++i)
+                bits |= static_cast<uint64_t>(rule.isValid(block[i])) << i;
+            bitmap[word] = bits;
+        }
+    }
+
+    void validateMany(const std::vector<std::string_view> &values, std::vector<uint64_t> &bitmap) const
+    {
+        bitmap.resize((values.size() + 63) / 64);
+        validateMany(values.data(), values.size(), bitmap.data());
+    }
+};
+
+// Non-virtual, allocation-free rules. The IPhoneValidator classes further down
+// are thin wrappers around these.
+class FormattedDomesticRule : public BatchValidator<FormattedDomesticRule>
+{
+public:
+    FORCE_INLINE bool isValid(std::string_view phone) const noexcept
+    {
+        const DigitProfile digits = profileDigits(phone);
+        return digits.count == 10 && digits.lead[0] != '0' && digits.lead[3] >= '2';
+    }
+    constexpr PhoneType getType() const noexcept { return PhoneType::FORMATTED_DOMESTIC; }
+};
+
+class InternationalPlusRule : public BatchValidator<InternationalPlusRule>
+{
+public:
+    FORCE_INLINE bool isValid(std::string_view phone) const noexcept
+    {
+        if (phone.empty() || phone[0] != '+')
+            return false;
+        const DigitProfile digits = profileDigits(phone);
+        return digits.count >= 7 && digits.count <= 15 && CallingCodes::isValidNumber(digits.lead, digits.count);
+    }
+    constexpr PhoneType getType() const noexcept { return PhoneType::INTERNATIONAL_PLUS; }
+};
+
+class PlainDigitRule : public BatchValidator<PlainDigitRule>
+{
+private:
+    size_t expectedLength;
+    PhoneType phoneType;
+
+public:
+    constexpr PlainDigitRule(size_t len, PhoneType type) noexcept : expectedLength(len), phoneType(type) {}
+
+    FORCE_INLINE bool isValid(std::string_view phone) const noexcept
+    {
+        if (phone.length() != expectedLength)
+            return false;
+        const DigitProfile digits = profileDigits(phone);
+        if (digits.count != expectedLength)
+            return false;
+
+        if (expectedLength == 10)
+            return digits.lead[0] != '0' && digits.lead[3] >= '2';
+        if (expectedLength == 11)
+            return digits.lead[0] == '1' && digits.lead[1] != '0';
+        return true;
+    }
+    constexpr PhoneType getType() const noexcept { return phoneType; }
+};
+
+class MobileDigitRule : public BatchValidator<MobileDigitRule>
+{
+public:
+    FORCE_INLINE bool isValid(std::string_view phone) const noexcept
+    {
+        const DigitProfile digits = profileDigits(phone);
+        if (digits.count == 10)
+            return digits.lead[0] >= '1' && digits.lead[0] <= '9';
+        if (digits.count == 12)
+            return digits.lead[0] == '9' && digits.lead[1] == '1' && digits.lead[2] >= '1' && digits.lead[2] <= '9';
+        return false;
+    }
+    constexpr PhoneType getType() const noexcept { return PhoneType::MOBILE_10_DIGIT; }
+};
+
+class FormattedDomesticValidator : public IPhoneValidator
+{
+public:
+    bool isValid(const std::string &phone) const noexcept override { return FormattedDomesticRule().isValid(phone); }
+    PhoneType getType() const noexcept override { return PhoneType::FORMATTED_DOMESTIC; }
+};
+
+class InternationalPlusValidator : public IPhoneValidator
+{
+public:
+    bool isValid(const std::string &phone) const noexcept override { return InternationalPlusRule().isValid(phone); }
+    PhoneType getType() const noexcept override { return PhoneType::INTERNATIONAL_PLUS; }
+};
+
+class PlainDigitValidator : public IPhoneValidator
+{
+private:
+    PlainDigitRule rule;
+
+public:
+    PlainDigitValidator(size_t len, PhoneType type) : rule(len, type) {}
+
+    bool isValid(const std::string &phone) const noexcept override { return rule.isValid(phone); }
+    PhoneType getType() const noexcept override { return rule.getType(); }
+};
+
+class MobileDigitValidator : public IPhoneValidator
+{
+public:
+    bool isValid(const std::string &phone) const noexcept override { return MobileDigitRule().isValid(phone); }
+    PhoneType getType() const noexcept override { return PhoneType::MOBILE_10_DIGIT; }
+};
+
+// ============================================================================
+// THREAD POOL
+// ============================================================================
+
+// Fixed set of worker threads that execute one indexed job at a time. The
+// calling thread takes part in the job, so a pool of N threads uses N cores.
+class ScanThreadPool
+{
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::mutex runMutex; // serializes run() callers
+
+    const std::function<void(size_t)> *task = nullptr;
+    size_t taskCount = 0;
+    std::atomic<size_t> nextIndex{0};
+    size_t activeWorkers = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+
+    void drain() noexcept
+    {
+        for (size_t i = nextIndex.fetch_add(1); i < taskCount; i = nextIndex.fetch_add(1))
+            (*task)(i);
+    }
+
+    void workerLoop()
+    {
+        uint64_t seen = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&]
+                          { return stopping || generation != seen; });
+                if (stopping)
+                    return;
+                seen = generation;
+            }
+            drain();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--activeWorkers == 0)
+                    done.notify_one();
+            }
+        }
+    }
+
+public:
+    explicit ScanThreadPool(size_t threads = std::thread::hardware_concurrency())
+    {
+        const size_t helpers = threads > 1 ? threads - 1 : 0;
+        workers.reserve(helpers);
+        for (size_t t = 0; t < helpers; ++t)
+            workers.emplace_back([this]
+                                 { workerLoop(); });
+    }
+
+    ~ScanThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    ScanThreadPool(const ScanThreadPool &) = delete;
+    ScanThreadPool &operator=(const ScanThreadPool &) = delete;
+
+    size_t size() const noexcept { return workers.size() + 1; }
+
+    // Calls fn(0) ... fn(count - 1) across the pool and returns when all are done.
+    void run(size_t count, const std::function<void(size_t)> &fn)
+    {
+        std::lock_guard<std::mutex> serial(runMutex);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = &fn;
+            taskCount = count;
+            nextIndex.store(0);
+            activeWorkers = workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+        drain();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&]
+                  { return activeWorkers == 0; });
+        task = nullptr;
+    }
+};
+
+// ============================================================================
+// BOUNDED QUEUE
+// ============================================================================
+
+// Fixed-capacity multi-producer, multi-consumer queue without locks. Each cell
+// carries a sequence number that tells producers and consumers whose turn it
+// is, so a push or pop costs one compare-and-swap on its own cache line. The
+// capacity is rounded up to a power of two. push() and pop() wait, with
+// backoff, while the queue is full or empty; that wait is the backpressure
+// between pipeline stages.
+template <typename T>
+class BoundedQueue
+{
+private:
+    struct alignas(64) Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> tail{0}; // next push
+    alignas(64) std::atomic<size_t> head{0}; // next pop
+
+    static void backoff(unsigned &attempt)
+    {
+        if (++attempt < 64)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+public:
+    explicit BoundedQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        cells.reset(new Cell[size]);
+        mask = size - 1;
+        for (size_t i = 0; i < size; ++i)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    // Moves from value only on success.
+    bool tryPush(T &&value)
+    {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = cells[pos & mask];
+            const size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false; // full
+            else
+                pos = tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    bool tryPop(T &out)
+    {
+        size_t pos = head.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = cells[pos & mask];
+            const size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    out = std::move(cell.value);
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false; // empty
+            else
+                pos = head.load(std::memory_order_relaxed);
+        }
+    }
+
+    void push(T value)
+    {
+        for (unsigned attempt = 0; !tryPush(std::move(value));)
+            backoff(attempt);
+    }
+
+    T pop()
+    {
+        T out;
+        for (unsigned attempt = 0; !tryPop(out);)
+            backoff(attempt);
+        return out;
+    }
+
+    size_t capacity() const noexcept { return mask + 1; }
+};
+
+// ============================================================================
+// FORMAT SELECTION
+// ============================================================================
+
+constexpr unsigned phoneFormatBit(PhoneType type) noexcept
+{
+    return 1u << static_cast<unsigned>(type);
+}
+
+template <typename... Types>
+constexpr unsigned phoneFormatMask(Types... types) noexcept
+{
+    return (0u | ... | phoneFormatBit(types));
+}
+
+constexpr unsigned ALL_PHONE_FORMATS = phoneFormatMask(
+    PhoneType::FORMATTED_DOMESTIC, PhoneType::FORMATTED_TOLL_FREE, PhoneType::INTERNATIONAL_PLUS,
+    PhoneType::INTERNATIONAL_00, PhoneType::PLAIN_10_DIGIT, PhoneType::PLAIN_11_DIGIT, PhoneType::MOBILE_10_DIGIT);
+
+// ============================================================================
+// PHONE SCANNER (Optimized for Performance)
+// ============================================================================
+
+// Formats is a phoneFormatMask() of the types to detect. A specialized scanner
+// reports a subset of the matches of the all-formats scanner that have an
+// enabled type, and does no more work for them. A disabled format is matched
+// only where its match could cover an enabled one, and is never emitted;
+// passes that cannot cover an enabled match are removed at compile time.
+//
+// Scanning is linear in the input whatever its content. Candidates start only
+// at '+', '(' or the first digit of a run, at most three start at any position
+// ("00", separated, then plain), and none reads more than LOOKAHEAD bytes or
+// looks back more than one. A failed candidate never moves the scan position
+// back, and a skipped run is read once, in place of the international
+// candidates, and then passed over. So no input byte is read more than
+// maxReadsPerByte() times.
+template <unsigned Formats = ALL_PHONE_FORMATS>
+class BasicPhoneScanner
+{
+    friend class StreamingPhoneScanner;
+    friend class IncrementalPhoneScanner;
+
+    static_assert(Formats != 0 && (Formats & ~ALL_PHONE_FORMATS) == 0, "Formats must select supported phone types");
+
+private:
+    static constexpr bool enabled(PhoneType type) noexcept { return (Formats & phoneFormatBit(type)) != 0; }
+
+    // A pass runs if it can produce an enabled type, or cover or resume-gate a
+    // pass that can; its disabled matches move the state but are not emitted.
+    // Formatted matches cover digits, never a '+', and a plain match is one
+    // digit run, inside which no candidate starts. International matches cover
+    // everything else, but with both international types disabled they are not
+    // matched at all: where one could start, the rest of the run of phone
+    // characters is skipped, as nothing pending outlives a byte no match
+    // contains. That can drop an enabled match from the run, never add one.
+    static constexpr bool SCAN_INTERNATIONAL = enabled(PhoneType::INTERNATIONAL_PLUS) || enabled(PhoneType::INTERNATIONAL_00);
+    static constexpr bool SCAN_PARENTHESIZED = (Formats & ~phoneFormatBit(PhoneType::INTERNATIONAL_PLUS)) != 0;
+    static constexpr bool SCAN_SEPARATED = SCAN_PARENTHESIZED;
+    static constexpr bool SCAN_PLAIN = enabled(PhoneType::MOBILE_10_DIGIT) || enabled(PhoneType::PLAIN_10_DIGIT) ||
+                                       enabled(PhoneType::PLAIN_11_DIGIT);
+
+    static constexpr size_t MAX_INPUT_SIZE = 10 * 1024 * 1024;
+    static constexpr size_t MAX_PHONE_LENGTH = 30;
+    static constexpr size_t MIN_DIGITS = 7;
+    static constexpr size_t MAX_DIGITS = 15;
+    // A candidate starting at i never reads past data[i + LOOKAHEAD - 1].
+    static constexpr size_t LOOKAHEAD = MAX_PHONE_LENGTH + 1;
+    // Plain candidates stop counting at one digit more than the longest plain format.
+    static constexpr size_t PLAIN_LOOKAHEAD = 12;
+    static_assert(PLAIN_LOOKAHEAD < LOOKAHEAD, "plain candidates must stay within the lookahead");
+
+    FORCE_INLINE void scanInternational(const char *data, size_t len, std::vector<PhoneMatch> &m) const noexcept
+    {
+        for (size_t i = 0; i < len; ++i)
+        {
+            size_t prefix = 0;
+            PhoneType type = PhoneType::INTERNATIONAL_PLUS;
+            if (data[i] == '+' && i + 1 < len && CharacterClassifier::isDigit(data[i + 1]))
+                prefix = 1;
+            else if (data[i] == '0' && i + 1 < len && data[i + 1] == '0' && (i == 0 || !CharacterClassifier::isDigit(data[i - 1])))
+            {
+                prefix = 2;
+                type = PhoneType::INTERNATIONAL_00;
+            }
+
+            if (prefix != 0)
+            {
+                size_t start = i;
+                std::string candidate(data + i, prefix);
+                int digitCount = 0;
+                i += prefix;
+
+                while (i < len && candidate.length() < MAX_PHONE_LENGTH)
+                {
+                    if (CharacterClassifier::isDigit(data[i]))
+                    {
+                        candidate += data[i];
+                        ++digitCount;
+                        ++i;
+                    }
+                    else if ((CharacterClassifier::isSeparator(data[i]) || data[i] == '(') && (digitCount > 0 || prefix == 2) &&
+                             i + 1 < len && (CharacterClassifier::isDigit(data[i + 1]) || data[i + 1] == '('))
+                    {
+                        candidate += data[i];
+                        ++i;
+                    }
+                    else if (data[i] == ')' && digitCount > 0)
+                    {
+                        candidate += data[i];
+                        ++i;
+                    }
+                    else
+                        break;
+                }
+
+                std::string digits = extractDigits(candidate.substr(prefix));
+                if (digits.length() >= MIN_DIGITS && digits.length() <= MAX_DIGITS && CallingCodes::isValidNumber(digits))
+                {
+                    m.emplace_back(type, candidate, digits, start);
+                    continue;
+                }
+                i = start;
+            }
+        }
+    }
+
+    FORCE_INLINE void scanFormattedNumbers(const char *data, size_t len, std::vector<PhoneMatch> &m) const noexcept
+    {
+        for (size_t i = 0; i < len; ++i)
+        {
+            if (data[i] == '(' && i + 14 <= len)
+            {
+                if (CharacterClassifier::isDigit(data[i + 1]) && CharacterClassifier::isDigit(data[i + 2]) &&
+                    CharacterClassifier::isDigit(data[i + 3]) && data[i + 4] == ')' &&
+                    (data[i + 5] == ' ' || data[i + 5] == '-'))
+                {
+                    size_t end = i + 6;
+                    std::string candidate = "(";
+                    candidate += data[i + 1];
+                    candidate += data[i + 2];
+                    candidate += data[i + 3];
+                    candidate += ") ";
+
+                    int digitCount = 0;
+                    while (end < len && digitCount < 7 && candidate.length() < MAX_PHONE_LENGTH)
+                    {
+                        if (CharacterClassifier::isDigit(data[end]))
+                        {
+                            candidate += data[end];
+                            ++digitCount;
+                            ++end;
+                        }
+                        else if (CharacterClassifier::isSeparator(data[end]) && digitCount > 0 && digitCount < 7)
+                        {
+                            candidate += data[end];
+                            ++end;
+                        }
+                        else
+                            break;
+                    }
+
+                    if (digitCount == 7)
+                    {
+                        std::string digits = extractDigits(candidate);
+                        if (digits.length() == 10 && digits[0] != '0' && digits[3] >= '2')
+                        {
+                            m.emplace_back(PhoneType::FORMATTED_DOMESTIC, candidate, digits, i);
+                            i = end - 1;
+                            continue;
+                        }
+                    }
+                }
+            }
+
+            if (CharacterClassifier::isDigit(data[i]) && (i == 0 || !CharacterClassifier::isDigit(data[i - 1])))
+            {
+                size_t start = i;
+                std::string candidate;
+                int digitCount = 0;
+                char separator = 0;
+                bool hasSeparator = false;
+
+                while (i < len && candidate.length() < MAX_PHONE_LENGTH)
+                {
+                    if (CharacterClassifier::isDigit(data[i]))
+                    {
+                        candidate += data[i];
+                        ++digitCount;
+                        ++i;
+                    }
+                    else if ((data[i] == '-' || data[i] == '.' || data[i] == ' ') &&
+                             digitCount > 0 && digitCount < 11 &&
+                             i + 1 < len && CharacterClassifier::isDigit(data[i + 1]))
+                    {
+                        if (separator == 0)
+                            separator = data[i];
+                        if (data[i] == separator)
+                        {
+                            candidate += data[i];
+                            hasSeparator = true;
+                            ++i;
+                        }
+                        else
+                            break;
+                    }
+                    else
+                        break;
+                }
+
+                if (hasSeparator && digitCount >= 10 && digitCount <= 11)
+                {
+                    std::string digits = extractDigits(candidate);
+
+                    if (digitCount == 10 && separator == ' ' && digits[0] >= '1' && digits[0] <= '9')
+                    {
+                        m.emplace_back(PhoneType::MOBILE_10_DIGIT, candidate, digits, start);
+                        continue;
+                    }
+                    else if (digitCount == 10 && digits[0] != '0' && digits[3] >= '2')
+                    {
+                        m.emplace_back(PhoneType::FORMATTED_DOMESTIC, candidate, digits, start);
+                        continue;
+                    }
+                    else if (digitCount == 11 && digits[0] == '1' && digits[1] != '0')
+                    {
+                        m.emplace_back(PhoneType::FORMATTED_TOLL_FREE, candidate, digits, start);
+                        continue;
+                    }
+                }
+                i = start;
+            }
+        }
+    }
+
+    FORCE_INLINE void scanPlainDigits(const char *data, size_t len, std::vector<PhoneMatch> &m) const noexcept
+    {
+        for (size_t i = 0; i < len; ++i)
+        {
+            if (!CharacterClassifier::isDigit(data[i]))
+                continue;
+            if (i > 0 && CharacterClassifier::isDigit(data[i - 1]))
+                continue;
+
+            size_t start = i;
+            int digitCount = 0;
+
+            while (i < len && CharacterClassifier::isDigit(data[i]))
+            {
+                ++digitCount;
+                ++i;
+            }
+
+            if (i < len && CharacterClassifier::isDigit(data[i]))
+                continue;
+
+            std::string candidate(data + start, digitCount);
+
+            if (digitCount == 10)
+            {
+                if (candidate[0] >= '6' && candidate[0] <= '9')
+                {
+                    m.emplace_back(PhoneType::MOBILE_10_DIGIT, candidate, candidate, start);
+                    continue;
+                }
+                else if (candidate[0] >= '2' && candidate[0] <= '5' && candidate[3] >= '2')
+                {
+                    m.emplace_back(PhoneType::PLAIN_10_DIGIT, candidate, candidate, start);
+                    continue;
+                }
+                else if (candidate[0] == '1')
+                {
+                    m.emplace_back(PhoneType::MOBILE_10_DIGIT, candidate, candidate, start);
+                    continue;
+                }
+            }
+            else if (digitCount == 11)
+            {
+                if (candidate[0] == '1' && candidate[1] != '0')
+                {
+                    m.emplace_back(PhoneType::PLAIN_11_DIGIT, candidate, candidate, start);
+                    continue;
+                }
+            }
+
+            i = start + digitCount - 1;
+        }
+    }
+
+    // ------------------------------------------------------------------------
+    // Single-pass engine. Every byte is classified once; the international and
+    // formatted "passes" are tracked as resume positions so the output matches
+    // the multi-pass engine exactly, already sorted and overlap-free.
+    // ------------------------------------------------------------------------
+
+    struct ScanState
+    {
+        size_t intlNext = 0; // first '+' the international format may start at
+        size_t fmtNext = 0;  // first position the formatted formats may start at
+        size_t lastEnd = 0;  // end of the last accepted match
+    };
+
+    // A disabled type is matched only for the state it moves, so it counts as a rejection.
+    static FORCE_INLINE void countMatched(ScanPass pass, PhoneType type) noexcept
+    {
+        static_cast<void>(pass);
+        if (enabled(type))
+            PHONE_STAT_ACCEPT(pass);
+        else
+            PHONE_STAT_REJECT(pass, RejectReason::DISABLED_FORMAT);
+    }
+
+    // prefixLength is 1 for '+' and 2 for "00". The digits after it must be an
+    // assigned calling code and a national number of a length in use there.
+    FORCE_INLINE bool matchInternational(const char *data, size_t len, size_t start, size_t prefixLength,
+                                         size_t &end) const noexcept
+    {
+        PHONE_STAT_CANDIDATE(ScanPass::INTERNATIONAL);
+        size_t i = start + prefixLength;
+        size_t digitCount = 0;
+        char lead[3] = {'0', '0', '0'};
+
+        while (i < len && i - start < MAX_PHONE_LENGTH)
+        {
+            if (CharacterClassifier::isDigit(data[i]))
+            {
+                if (digitCount < 3)
+                    lead[digitCount] = data[i];
+                ++digitCount;
+                ++i;
+            }
+            else if ((CharacterClassifier::isSeparator(data[i]) || data[i] == '(') && (digitCount > 0 || prefixLength == 2) &&
+                     i + 1 < len && (CharacterClassifier::isDigit(data[i + 1]) || data[i + 1] == '('))
+                ++i;
+            else if (data[i] == ')' && digitCount > 0)
+                ++i;
+            else
+                break;
+        }
+
+        end = i;
+        if (digitCount < MIN_DIGITS || digitCount > MAX_DIGITS)
+        {
+            PHONE_STAT_REJECT(ScanPass::INTERNATIONAL, RejectReason::DIGIT_COUNT);
+            return false;
+        }
+        if (UNLIKELY(!CallingCodes::isValidNumber(lead, digitCount)))
+        {
+            PHONE_STAT_REJECT(ScanPass::INTERNATIONAL, CallingCodes::codeLength(lead) == 0 ? RejectReason::CALLING_CODE
+                                                                                          : RejectReason::NATIONAL_LENGTH);
+            return false;
+        }
+        countMatched(ScanPass::INTERNATIONAL, prefixLength == 1 ? PhoneType::INTERNATIONAL_PLUS : PhoneType::INTERNATIONAL_00);
+        return true;
+    }
+
+    FORCE_INLINE bool matchParenthesized(const char *data, size_t len, size_t start, size_t &end) const noexcept
+    {
+        PHONE_STAT_CANDIDATE(ScanPass::FORMATTED);
+        if (!(CharacterClassifier::isDigit(data[start + 1]) && CharacterClassifier::isDigit(data[start + 2]) &&
+              CharacterClassifier::isDigit(data[start + 3]) && data[start + 4] == ')' &&
+              (data[start + 5] == ' ' || data[start + 5] == '-')))
+        {
+            PHONE_STAT_REJECT(ScanPass::FORMATTED, RejectReason::SEPARATOR);
+            return false;
+        }
+
+        size_t i = start + 6;
+        int digitCount = 0;
+        while (i < len && digitCount < 7 && i - start < MAX_PHONE_LENGTH)
+        {
+            if (CharacterClassifier::isDigit(data[i]))
+            {
+                ++digitCount;
+                ++i;
+            }
+            else if (CharacterClassifier::isSeparator(data[i]) && digitCount > 0 && digitCount < 7)
+                ++i;
+            else
+                break;
+        }
+
+        end = i;
+        if (digitCount == 7 && data[start + 1] != '0' && data[start + 6] >= '2')
+        {
+            countMatched(ScanPass::FORMATTED, PhoneType::FORMATTED_DOMESTIC);
+            return true;
+        }
+        PHONE_STAT_REJECT(ScanPass::FORMATTED, digitCount != 7          ? RejectReason::DIGIT_COUNT
+                                               : data[start + 1] == '0' ? RejectReason::AREA_CODE
+                                                                        : RejectReason::EXCHANGE_CODE);
+        return false;
+    }
+
+    FORCE_INLINE bool matchSeparated(const char *data, size_t len, size_t start, size_t &end, PhoneType &type) const noexcept
+    {
+        PHONE_STAT_CANDIDATE(ScanPass::FORMATTED);
+        size_t i = start;
+        int digitCount = 0;
+        char separator = 0;
+        bool hasSeparator = false;
+        char d1 = 0, d3 = 0;
+
+        while (i < len && i - start < MAX_PHONE_LENGTH)
+        {
+            if (CharacterClassifier::isDigit(data[i]))
+            {
+                if (digitCount == 1)
+                    d1 = data[i];
+                else if (digitCount == 3)
+                    d3 = data[i];
+                ++digitCount;
+                ++i;
+            }
+            else if ((data[i] == '-' || data[i] == '.' || data[i] == ' ') &&
+                     digitCount > 0 && digitCount < 11 &&
+                     i + 1 < len && CharacterClassifier::isDigit(data[i + 1]))
+            {
+                if (separator == 0)
+                    separator = data[i];
+                if (data[i] != separator)
+                    break;
+                hasSeparator = true;
+                ++i;
+            }
+            else
+                break;
+        }
+
+        end = i;
+        if (!hasSeparator || digitCount < 10 || digitCount > 11)
+        {
+            PHONE_STAT_REJECT(ScanPass::FORMATTED, !hasSeparator ? RejectReason::SEPARATOR : RejectReason::DIGIT_COUNT);
+            return false;
+        }
+
+        // Classified as in the all-formats scanner; acceptMatch drops disabled types.
+        const char d0 = data[start];
+        if (digitCount == 10 && separator == ' ' && d0 >= '1')
+            type = PhoneType::MOBILE_10_DIGIT;
+        else if (digitCount == 10 && d0 != '0' && d3 >= '2')
+            type = PhoneType::FORMATTED_DOMESTIC;
+        else if (digitCount == 11 && d0 == '1' && d1 != '0')
+            type = PhoneType::FORMATTED_TOLL_FREE;
+        else
+        {
+            PHONE_STAT_REJECT(ScanPass::FORMATTED, nanpRejectReason(digitCount, d0, d1, d3));
+            return false;
+        }
+        countMatched(ScanPass::FORMATTED, type);
+        return true;
+    }
+
+    FORCE_INLINE bool matchPlain(const char *data, size_t len, size_t start, size_t &end, PhoneType &type) const noexcept
+    {
+        // Only runs of exactly 10 or 11 digits qualify, so counting stops at 12.
+        PHONE_STAT_CANDIDATE(ScanPass::PLAIN);
+        size_t i = start;
+        while (i < len && i - start < PLAIN_LOOKAHEAD && CharacterClassifier::isDigit(data[i]))
+            ++i;
+
+        const size_t digitCount = i - start;
+        end = i;
+        if (digitCount == 10)
+        {
+            if (enabled(PhoneType::MOBILE_10_DIGIT) && data[start] >= '6' && data[start] <= '9')
+                type = PhoneType::MOBILE_10_DIGIT;
+            else if (enabled(PhoneType::PLAIN_10_DIGIT) && data[start] >= '2' && data[start] <= '5' && data[start + 3] >= '2')
+                type = PhoneType::PLAIN_10_DIGIT;
+            else if (enabled(PhoneType::MOBILE_10_DIGIT) && data[start] == '1')
+                type = PhoneType::MOBILE_10_DIGIT;
+            else
+            {
+                PHONE_STAT_REJECT(ScanPass::PLAIN, nanpRejectReason(10, data[start], data[start + 1], data[start + 3]));
+                return false;
+            }
+            PHONE_STAT_ACCEPT(ScanPass::PLAIN);
+            return true;
+        }
+        if (enabled(PhoneType::PLAIN_11_DIGIT) && digitCount == 11 && data[start] == '1' && data[start + 1] != '0')
+        {
+            type = PhoneType::PLAIN_11_DIGIT;
+            PHONE_STAT_ACCEPT(ScanPass::PLAIN);
+            return true;
+        }
+        PHONE_STAT_REJECT(ScanPass::PLAIN, digitCount == 11 ? nanpRejectReason(11, data[start], data[start + 1], 0)
+                                                            : RejectReason::DIGIT_COUNT);
+        return false;
+    }
+
+    // Why a 10- or 11-digit candidate that failed classification was rejected.
+    static constexpr RejectReason nanpRejectReason(int digitCount, char d0, char d1, char d3) noexcept
+    {
+        if (digitCount == 11)
+            return d0 != '1' ? RejectReason::PREFIX : d1 == '0' ? RejectReason::AREA_CODE : RejectReason::DISABLED_FORMAT;
+        return d0 == '0' ? RejectReason::AREA_CODE : d3 < '2' ? RejectReason::EXCHANGE_CODE : RejectReason::DISABLED_FORMAT;
+    }
+
+    template <typename Emit>
+    static FORCE_INLINE bool emitMatch(Emit &emit, PhoneType type, size_t start, size_t end)
+    {
+        if constexpr (std::is_void_v<std::invoke_result_t<Emit &, PhoneType, size_t, size_t>>)
+        {
+            emit(type, start, end);
+            return true;
+        }
+        else
+            return static_cast<bool>(emit(type, start, end));
+    }
+
+    // Skips an international candidate of a scanner without international
+    // formats: nothing from start to the end of its run of phone characters is
+    // matched. Returns the last position skipped.
+    static FORCE_INLINE size_t skipRun(const char *data, size_t len, size_t start, ScanState &state) noexcept
+    {
+        PHONE_STAT_CANDIDATE(ScanPass::INTERNATIONAL);
+        PHONE_STAT_REJECT(ScanPass::INTERNATIONAL, RejectReason::DISABLED_FORMAT);
+        size_t end = start + 1;
+        while (end < len && CharacterClassifier::isPhoneChar(data[end]))
+            ++end;
+        state.intlNext = std::max(state.intlNext, end);
+        state.fmtNext = std::max(state.fmtNext, end);
+        state.lastEnd = std::max(state.lastEnd, end);
+        return end - 1;
+    }
+
+    // Accepts a match whose type may be disabled. Returns false if emit stopped the scan.
+    template <typename Emit>
+    FORCE_INLINE bool acceptMatch(Emit &emit, PhoneType type, size_t start, size_t end,
+                                  ScanState &state) const
+    {
+        if (start < state.lastEnd)
+        {
+            if (enabled(type))
+                PHONE_STAT_ADD(ScanStats::OVERLAP_LOSERS, 1);
+            return true;
+        }
+        state.lastEnd = end;
+        if (!enabled(type))
+            return true;
+        return emitMatch(emit, type, start, end);
+    }
+
+    // Scans positions [from, to) of data[0, len). Lookahead may read up to len.
+    // emit(type, start, end) is called in position order for accepted matches;
+    // it may return false to stop the scan, in which case scanRange returns false.
+    template <typename Emit>
+    FORCE_INLINE bool scanRange(const char *data, size_t len, size_t from, size_t to,
+                                ScanState &state, Emit &&emit) const
+    {
+        PHONE_STAT_ADD(ScanStats::SCANS, 1);
+        PHONE_STAT_ADD(ScanStats::BYTES, to - from);
+        PHONE_STAT_TIMER(ScanStats::SCAN_NANOS);
+        for (size_t i = from; i < to; ++i)
+        {
+            if (!CharacterClassifier::isCandidateStart(data[i]))
+            {
+                i = CandidatePrefilter::find(data, i + 1, to);
+                if (i >= to)
+                    break;
+            }
+
+            const unsigned char c = data[i];
+
+            size_t end;
+            PhoneType type;
+
+            if (CharacterClassifier::isPlus(c))
+            {
+                if (i >= state.intlNext && i + 1 < len && CharacterClassifier::isDigit(data[i + 1]))
+                {
+                    if constexpr (!SCAN_INTERNATIONAL)
+                        i = skipRun(data, len, i, state);
+                    else if (matchInternational(data, len, i, 1, end))
+                    {
+                        state.intlNext = end + 1;
+                        if (!acceptMatch(emit, PhoneType::INTERNATIONAL_PLUS, i, end, state))
+                            return false;
+                    }
+                }
+                continue;
+            }
+
+            if (c == '(')
+            {
+                if (SCAN_PARENTHESIZED && i >= state.fmtNext && i + 14 <= len && matchParenthesized(data, len, i, end))
+                {
+                    state.fmtNext = end;
+                    if (!acceptMatch(emit, PhoneType::FORMATTED_DOMESTIC, i, end, state))
+                        return false;
+                }
+                continue;
+            }
+
+            if (!CharacterClassifier::isDigit(c) || (i > 0 && CharacterClassifier::isDigit(data[i - 1])))
+                continue;
+
+            // A "00" number takes the international resume position and, like
+            // every international match, wins over formats starting at i.
+            if (c == '0' && i >= state.intlNext && i + 1 < len && data[i + 1] == '0')
+            {
+                if constexpr (!SCAN_INTERNATIONAL)
+                {
+                    i = skipRun(data, len, i, state);
+                    continue;
+                }
+                else if (matchInternational(data, len, i, 2, end))
+                {
+                    state.intlNext = end + 1;
+                    if (!acceptMatch(emit, PhoneType::INTERNATIONAL_00, i, end, state))
+                        return false;
+                }
+            }
+
+            if (SCAN_SEPARATED && i >= state.fmtNext && matchSeparated(data, len, i, end, type))
+            {
+                state.fmtNext = end + 1;
+                if (!acceptMatch(emit, type, i, end, state))
+                    return false;
+            }
+
+            if (SCAN_PLAIN && i >= state.lastEnd && matchPlain(data, len, i, end, type))
+            {
+                state.lastEnd = end;
+                if (!emitMatch(emit, type, i, end))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename Visitor>
+    ScanStatus scanLimited(std::string_view text, const ScanOptions &options, Visitor &&visit,
+                           size_t &scanned) const
+    {
+        const size_t len = text.length();
+        const size_t limit = std::min(len, options.maxBytes);
+        scanned = 0;
+        // Checked on the whole text, as in scan(), so a limited scan stays a prefix of it.
+        if (UNLIKELY(len > MAX_INPUT_SIZE))
+            return ScanStatus::INPUT_TOO_LARGE;
+        if (UNLIKELY(len < MIN_DIGITS))
+        {
+            scanned = limit;
+            return limit < len ? ScanStatus::BYTE_LIMIT : ScanStatus::COMPLETE;
+        }
+
+        const char *data = text.data();
+        const bool timed = options.deadline != ScanOptions::Clock::time_point::max();
+        const size_t interval = std::max<size_t>(options.checkInterval, 1);
+        ScanStatus status = ScanStatus::COMPLETE;
+        size_t found = 0;
+        // The match limit is reported only once a match past it turns up, and
+        // scanned is where the scan stopped: the start of that unreported match,
+        // or the end of the match the visitor stopped on.
+        auto emit = [&](PhoneType type, size_t start, size_t end)
+        {
+            if (UNLIKELY(found == options.maxMatches))
+            {
+                status = ScanStatus::MATCH_LIMIT;
+                scanned = start;
+                return false;
+            }
+            ++found;
+            const PhoneMatchView match{type, start, std::string_view(data + start, end - start)};
+            if constexpr (std::is_void_v<std::invoke_result_t<Visitor &, const PhoneMatchView &>>)
+                visit(match);
+            else if (visit(match) == ScanControl::STOP)
+            {
+                status = ScanStatus::STOPPED;
+                scanned = end;
+                return false;
+            }
+            return true;
+        };
+
+        ScanState state;
+        for (size_t pos = 0; pos < limit;)
+        {
+            const size_t to = limit - pos > interval ? pos + interval : limit;
+            if (!scanRange(data, len, pos, to, state, emit))
+                return status;
+            pos = to;
+            if (timed && pos < limit && ScanOptions::Clock::now() >= options.deadline)
+            {
+                scanned = pos;
+                return ScanStatus::DEADLINE;
+            }
+        }
+        scanned = limit;
+        return limit < len ? ScanStatus::BYTE_LIMIT : ScanStatus::COMPLETE;
+    }
+
+public:
+    // Pushes each match to visit(const PhoneMatchView &) in position order,
+    // without building a container. The visitor may return ScanControl::STOP
+    // to end the scan at once. Returns false if the scan was stopped.
+    template <typename Visitor>
+    bool scan(std::string_view text, Visitor &&visit) const
+    {
+        const size_t len = text.length();
+        if (UNLIKELY(len > MAX_INPUT_SIZE || len < MIN_DIGITS))
+            return true;
+
+        const char *data = text.data();
+        ScanState state;
+        return scanRange(data, len, 0, len, state, [&](PhoneType type, size_t start, size_t end)
+                         {
+            const PhoneMatchView match{type, start, std::string_view(data + start, end - start)};
+            if constexpr (std::is_void_v<std::invoke_result_t<Visitor &, const PhoneMatchView &>>)
+            {
+                visit(match);
+                return true;
+            }
+            else
+                return visit(match) != ScanControl::STOP; });
+    }
+
+    // scan() under the limits in options; returns which one ended it, if any.
+    // Text is scanned in checkInterval pieces with the scan state carried
+    // across, so the matches reported are exactly a prefix of the unlimited
+    // scan's, and at most one piece of work is done past the deadline.
+    template <typename Visitor>
+    ScanStatus scan(std::string_view text, const ScanOptions &options, Visitor &&visit) const
+    {
+        size_t scanned;
+        return scanLimited(text, options, visit, scanned);
+    }
+
+    ScanResult extractViews(std::string_view text, const ScanOptions &options) const
+    {
+        ScanResult result;
+        result.status = scanLimited(text, options, [&](const PhoneMatchView &match)
+                                    { result.matches.push_back(match); }, result.scannedBytes);
+        return result;
+    }
+
+    bool contains(std::string_view text) const noexcept
+    {
+        ContainsSink sink;
+        scan(text, sink);
+        return sink.found;
+    }
+
+    size_t count(std::string_view text) const noexcept
+    {
+        CountSink sink;
+        scan(text, sink);
+        return sink.count;
+    }
+
+    // Writes at most n matches to out and returns how many were written.
+    size_t firstN(std::string_view text, PhoneMatchView *out, size_t n) const noexcept
+    {
+        if (n == 0)
+            return 0;
+        FirstNSink sink(out, n);
+        scan(text, sink);
+        return sink.count;
+    }
+
+    std::vector<PhoneMatch> extract(const std::string &text) const noexcept
+    {
+        std::vector<PhoneMatch> matches;
+        const size_t len = text.length();
+
+        if (UNLIKELY(len > MAX_INPUT_SIZE || len < MIN_DIGITS))
+            return matches;
+
+        const char *data = text.data();
+        ScanState state;
+        scanRange(data, len, 0, len, state, [&](PhoneType type, size_t start, size_t end)
+                  { matches.push_back(toPhoneMatch({type, start, std::string_view(data + start, end - start)})); });
+        return matches;
+    }
+
+    // extract() with the vector and every string in `resource`, for example a
+    // PhoneArena that the caller resets after each request.
+    std::pmr::vector<PmrPhoneMatch> extract(std::string_view text, std::pmr::memory_resource *resource) const
+    {
+        std::pmr::vector<PmrPhoneMatch> matches(resource);
+        const size_t len = text.length();
+
+        if (UNLIKELY(len > MAX_INPUT_SIZE || len < MIN_DIGITS))
+            return matches;
+
+        const char *data = text.data();
+        ScanState state;
+        scanRange(data, len, 0, len, state, [&](PhoneType type, size_t start, size_t end)
+                  { matches.push_back(toPhoneMatch({type, start, std::string_view(data + start, end - start)}, resource)); });
+        return matches;
+    }
+
+    // Zero-copy variant: no per-match allocation, digits are normalized on demand.
+    std::vector<PhoneMatchView> extractViews(std::string_view text) const noexcept
+    {
+        std::vector<PhoneMatchView> matches;
+        const size_t len = text.length();
+
+        if (UNLIKELY(len > MAX_INPUT_SIZE || len < MIN_DIGITS))
+            return matches;
+
+        const char *data = text.data();
+        ScanState state;
+        scanRange(data, len, 0, len, state, [&](PhoneType type, size_t start, size_t end)
+                  { matches.push_back({type, start, std::string_view(data + start, end - start)}); });
+        return matches;
+    }
+
+    std::pmr::vector<PhoneMatchView> extractViews(std::string_view text, std::pmr::memory_resource *resource) const
+    {
+        std::pmr::vector<PhoneMatchView> matches(resource);
+        scan(text, [&](const PhoneMatchView &match)
+             { matches.push_back(match); });
+        return matches;
+    }
+
+    // Passes text to write(std::string_view) with every match masked, in one
+    // pass and without allocating: unmatched spans point into text, masked
+    // matches into a small stack buffer. There is no input size limit, so
+    // nothing passes unmasked because of it. Returns the number of matches.
+    template <typename Writer>
+    size_t redact(std::string_view text, Writer &&write, RedactionPolicy policy = RedactionPolicy::FULL,
+                  char mask = '*') const
+    {
+        const char *data = text.data();
+        const size_t len = text.length();
+        size_t copied = 0, masked = 0;
+        char buffer[LOOKAHEAD];
+        ScanState state;
+        scanRange(data, len, 0, len, state, [&](PhoneType, size_t start, size_t end)
+                  {
+            if (start > copied)
+                write(std::string_view(data + copied, start - copied));
+            maskPhone(data + start, buffer, end - start, policy, mask);
+            write(std::string_view(buffer, end - start));
+            copied = end;
+            ++masked; });
+        if (copied < len)
+            write(std::string_view(data + copied, len - copied));
+        return masked;
+    }
+
+    std::string redacted(std::string_view text, RedactionPolicy policy = RedactionPolicy::FULL, char mask = '*') const
+    {
+        std::string out;
+        out.reserve(text.length());
+        redact(text, [&](std::string_view piece)
+               { out.append(piece); }, policy, mask);
+        return out;
+    }
+
+    // Masks every match in data[0, len) in place and returns how many there were.
+    // The scanner reads one byte behind its position and still visits the bytes
+    // of a match after reporting it, so each match is masked only once the
+    // next one is found.
+    size_t redactInPlace(char *data, size_t len, RedactionPolicy policy = RedactionPolicy::FULL,
+                         char mask = '*') const noexcept
+    {
+        size_t pendingStart = 0, pendingEnd = 0, masked = 0;
+        ScanState state;
+        scanRange(data, len, 0, len, state, [&](PhoneType, size_t start, size_t end)
+                  {
+            maskPhone(data + pendingStart, data + pendingStart, pendingEnd - pendingStart, policy, mask);
+            pendingStart = start;
+            pendingEnd = end;
+            ++masked; });
+        maskPhone(data + pendingStart, data + pendingStart, pendingEnd - pendingStart, policy, mask);
+        return masked;
+    }
+
+    // Tags every match as known or unknown against index in the same scan.
+    std::vector<TaggedPhoneMatch> extractTagged(std::string_view text, const PhoneKeyIndex &index) const
+    {
+        std::vector<TaggedPhoneMatch> matches;
+        scan(text, [&](const PhoneMatchView &match)
+             {
+            const PhoneKey key = PhoneKey::fromMatch(match);
+            matches.push_back({match, key, index.contains(key)}); });
+        return matches;
+    }
+
+    // Scans count documents (anything convertible to std::string_view) into out,
+    // which is cleared first. No allocation happens once out has grown to fit.
+    template <typename Document>
+    void extractBatch(const Document *docs, size_t count, PhoneMatchBatch &out) const
+    {
+        out.clear();
+        out.offsets.reserve(count + 1);
+
+        for (size_t d = 0; d < count; ++d)
+        {
+            const std::string_view text(docs[d]);
+            const size_t len = text.length();
+            if (LIKELY(len <= MAX_INPUT_SIZE && len >= MIN_DIGITS))
+            {
+                const char *data = text.data();
+                ScanState state;
+                scanRange(data, len, 0, len, state, [&](PhoneType type, size_t start, size_t end)
+                          { out.matches.push_back({type, start, std::string_view(data + start, end - start)}); });
+            }
+            out.offsets.push_back(out.matches.size());
+        }
+    }
+
+    // Same, into this thread's ScannerContext. The result stays valid until the
+    // next extractBatch() call on this thread and borrows from the documents.
+    template <typename Document>
+    const PhoneMatchBatch &extractBatch(const Document *docs, size_t count) const
+    {
+        PhoneMatchBatch &batch = ScannerContext::local().batch;
+        extractBatch(docs, count, batch);
+        return batch;
+    }
+
+    template <typename Document>
+    const PhoneMatchBatch &extractBatch(const std::vector<Document> &docs) const
+    {
+        return extractBatch(docs.data(), docs.size());
+    }
+
+    // Scans count documents into columns, which are cleared first; document ids
+    // start at firstDocument. No allocation happens once out has grown to fit.
+    // Arrow's int32 offsets cap a batch at 2^31 digits (over 140 million matches).
+    template <typename Document>
+    void extractColumns(const Document *docs, size_t count, PhoneMatchColumns &out, uint32_t firstDocument = 0) const
+    {
+        out.clear();
+        for (size_t d = 0; d < count; ++d)
+        {
+            const std::string_view text(docs[d]);
+            const size_t len = text.length();
+            if (UNLIKELY(len > MAX_INPUT_SIZE || len < MIN_DIGITS))
+                continue;
+
+            const char *data = text.data();
+            const uint32_t id = firstDocument + static_cast<uint32_t>(d);
+            ScanState state;
+            scanRange(data, len, 0, len, state, [&](PhoneType type, size_t start, size_t end)
+                      {
+                out.document.push_back(id);
+                out.position.push_back(static_cast<uint32_t>(start));
+                out.length.push_back(static_cast<uint8_t>(end - start));
+                out.type.push_back(static_cast<uint8_t>(type));
+                for (size_t i = start + dialPrefixLength(type); i < end; ++i)
+                    if (CharacterClassifier::isDigit(data[i]))
+                        out.digits.push_back(data[i]);
+                out.digitOffsets.push_back(static_cast<int32_t>(out.digits.size())); });
+        }
+    }
+
+    template <typename Document>
+    void extractColumns(const std::vector<Document> &docs, PhoneMatchColumns &out, uint32_t firstDocument = 0) const
+    {
+        extractColumns(docs.data(), docs.size(), out, firstDocument);
+    }
+
+    static constexpr size_t lookahead() noexcept { return LOOKAHEAD; }
+    // Worst-case reads of one input byte in a scan: three candidates' lookahead,
+    // plus the classification and the one-byte look-back.
+    static constexpr size_t maxReadsPerByte() noexcept { return 3 * LOOKAHEAD + 2; }
+    // Longest text that the one-shot calls (extract, scan, ...) accept.
+    static constexpr size_t maxInputSize() noexcept { return MAX_INPUT_SIZE; }
+
+    static constexpr size_t DEFAULT_MIN_SHARD_SIZE = 256 * 1024;
+
+    // Same result as extract(), with the buffer split into shards scanned on
+    // the pool. Shards start right after a non-phone character: no candidate
+    // can span such a byte and every format's resume position is behind it,
+    // so each shard starts from a fresh state and the per-shard results
+    // simply concatenate in order.
+    std::vector<PhoneMatch> extractParallel(const std::string &text, ScanThreadPool &pool,
+                                            size_t minShardSize = DEFAULT_MIN_SHARD_SIZE) const
+    {
+        const size_t len = text.length();
+        const size_t shardCount = std::min(pool.size(), len / std::max<size_t>(minShardSize, 1));
+        if (len > MAX_INPUT_SIZE || shardCount < 2)
+            return extract(text);
+
+        const char *data = text.data();
+        std::vector<size_t> bounds{0};
+        for (size_t k = 1; k < shardCount; ++k)
+        {
+            size_t b = std::max(k * len / shardCount, bounds.back() + 1);
+            const size_t limit = (k + 1) * len / shardCount;
+            while (b < limit && CharacterClassifier::isPhoneChar(data[b - 1]))
+                ++b;
+            if (b < limit)
+                bounds.push_back(b);
+        }
+        bounds.push_back(len);
+
+        std::vector<std::vector<PhoneMatch>> shards(bounds.size() - 1);
+        pool.run(shards.size(), [&](size_t k)
+                 {
+            ScanState state;
+            scanRange(data, len, bounds[k], bounds[k + 1], state, [&](PhoneType type, size_t start, size_t end)
+                      { shards[k].push_back(toPhoneMatch({type, start, std::string_view(data + start, end - start)})); }); });
+
+        size_t total = 0;
+        for (const auto &shard : shards)
+            total += shard.size();
+
+        std::vector<PhoneMatch> matches;
+        matches.reserve(total);
+        for (auto &shard : shards)
+            std::move(shard.begin(), shard.end(), std::back_inserter(matches));
+        return matches;
+    }
+
+    std::vector<PhoneMatch> extractParallel(const std::string &text, size_t threads) const
+    {
+        ScanThreadPool pool(threads);
+        return extractParallel(text, pool);
+    }
+
+    // Original three-pass engine, kept as the reference implementation of the
+    // all-formats scanner.
+    template <unsigned F = Formats, typename = std::enable_if_t<F == ALL_PHONE_FORMATS>>
+    std::vector<PhoneMatch> extractMultiPass(const std::string &text) const noexcept
+    {
+        std::vector<PhoneMatch> matches;
+        const size_t len = text.length();
+
+        if (UNLIKELY(len > MAX_INPUT_SIZE || len < MIN_DIGITS))
+            return matches;
+
+        matches.reserve(20);
+        const char *data = text.data();
+
+        {
+            PHONE_STAT_TIMER(ScanStats::passNanos(ScanPass::INTERNATIONAL));
+            scanInternational(data, len, matches);
+        }
+        {
+            PHONE_STAT_TIMER(ScanStats::passNanos(ScanPass::FORMATTED));
+            scanFormattedNumbers(data, len, matches);
+        }
+        {
+            PHONE_STAT_TIMER(ScanStats::passNanos(ScanPass::PLAIN));
+            scanPlainDigits(data, len, matches);
+        }
+
+        if (matches.empty())
+            return matches;
+
+        std::stable_sort(matches.begin(), matches.end(), [](auto &a, auto &b)
+                         { return a.position < b.position; });
+
+        std::vector<PhoneMatch> result;
+        result.reserve(matches.size());
+        size_t lastEnd = 0;
+
+        for (auto &match : matches)
+        {
+            if (match.position >= lastEnd)
+            {
+                lastEnd = match.position + match.value.length();
+                result.push_back(std::move(match));
+            }
+            else
+                PHONE_STAT_ADD(ScanStats::OVERLAP_LOSERS, 1);
+        }
+
+        return result;
+    }
+
+    // One pass of the reference engine on its own: unsorted, overlaps kept.
+    // For profiling the passes separately.
+    template <unsigned F = Formats, typename = std::enable_if_t<F == ALL_PHONE_FORMATS>>
+    std::vector<PhoneMatch> extractPass(const std::string &text, ScanPass pass) const noexcept
+    {
+        std::vector<PhoneMatch> matches;
+        const size_t len = text.length();
+
+        if (UNLIKELY(len > MAX_INPUT_SIZE || len < MIN_DIGITS))
+            return matches;
+
+        PHONE_STAT_TIMER(ScanStats::passNanos(pass));
+        switch (pass)
+        {
+        case ScanPass::INTERNATIONAL:
+            scanInternational(text.data(), len, matches);
+            break;
+        case ScanPass::FORMATTED:
+            scanFormattedNumbers(text.data(), len, matches);
+            break;
+        case ScanPass::PLAIN:
+            scanPlainDigits(text.data(), len, matches);
+            break;
+        }
+        return matches;
+    }
+};
+
+using PhoneScanner = BasicPhoneScanner<>;
+
+// PhoneScannerFor<PhoneType::INTERNATIONAL_PLUS, PhoneType::MOBILE_10_DIGIT> detects only those formats.
+template <PhoneType... Types>
+using PhoneScannerFor = BasicPhoneScanner<phoneFormatMask(Types...)>;
+
+// ============================================================================
+// STREAMING SCANNER
+// ============================================================================
+
+// Stateful scanner for inputs of any size. Chunks are scanned in place; only
+// the last LOOKAHEAD bytes (plus one byte of left context) are carried over,
+// so memory stays constant and numbers spanning a chunk boundary are found
+// with absolute positions. The results equal a one-shot extract() of the
+// concatenated stream, without the MAX_INPUT_SIZE limit.
+class StreamingPhoneScanner
+{
+private:
+    static constexpr size_t LOOKAHEAD = PhoneScanner::LOOKAHEAD;
+    static constexpr size_t STITCH_SIZE = 2 * LOOKAHEAD;
+
+    PhoneScanner scanner;
+    PhoneScanner::ScanState state; // absolute positions
+    std::string carry;             // stream bytes [carryBase, streamEnd)
+    size_t carryBase = 0;
+    size_t next = 0; // first position not yet scanned
+    bool finished = false;
+
+    // Scans positions [from, to) of a buffer that starts at absolute offset base.
+    void scanBuffer(const char *data, size_t len, size_t base, size_t from, size_t to, std::vector<PhoneMatch> &out)
+    {
+        PhoneScanner::ScanState local;
+        local.intlNext = state.intlNext > base ? state.intlNext - base : 0;
+        local.fmtNext = state.fmtNext > base ? state.fmtNext - base : 0;
+        local.lastEnd = state.lastEnd > base ? state.lastEnd - base : 0;
+
+        scanner.scanRange(data, len, from, to, local, [&](PhoneType type, size_t start, size_t end)
+                          {
+            PhoneMatch match = toPhoneMatch({type, start, std::string_view(data + start, end - start)});
+            match.position += base;
+            out.push_back(std::move(match)); });
+
+        state.intlNext = std::max(state.intlNext, local.intlNext + base);
+        state.fmtNext = std::max(state.fmtNext, local.fmtNext + base);
+        state.lastEnd = std::max(state.lastEnd, local.lastEnd + base);
+        next = base + to;
+    }
+
+    // Scans whatever the carry buffer can decide and drops the bytes no longer needed.
+    void scanCarry(bool atEnd, size_t limit, std::vector<PhoneMatch> &out)
+    {
+        const size_t len = carry.size();
+        const size_t from = next - carryBase;
+        size_t to = atEnd ? len : (len > LOOKAHEAD ? len - LOOKAHEAD : 0);
+        to = std::min(to, limit - carryBase);
+        if (to > from)
+            scanBuffer(carry.data(), len, carryBase, from, to, out);
+
+        const size_t keepFrom = next > carryBase ? next - carryBase - 1 : 0;
+        carry.erase(0, keepFrom);
+        carryBase += keepFrom;
+    }
+
+public:
+    StreamingPhoneScanner() { carry.reserve(STITCH_SIZE * 3); }
+
+    std::vector<PhoneMatch> feed(std::string_view chunk)
+    {
+        std::vector<PhoneMatch> out;
+        if (UNLIKELY(finished || chunk.empty()))
+            return out;
+
+        const size_t chunkBase = carryBase + carry.size();
+        if (chunk.size() < 2 * STITCH_SIZE)
+        {
+            carry.append(chunk.data(), chunk.size());
+            scanCarry(false, SIZE_MAX, out);
+            return out;
+        }
+
+        // Stitch the boundary: carry plus the head of the chunk decides every
+        // position up to chunkBase + LOOKAHEAD, from where the chunk has its own
+        // left context and enough lookahead to be scanned without copying.
+        carry.append(chunk.data(), STITCH_SIZE);
+        scanCarry(false, chunkBase + LOOKAHEAD, out);
+
+        scanBuffer(chunk.data(), chunk.size(), chunkBase, next - chunkBase, chunk.size() - LOOKAHEAD, out);
+
+        carryBase = next - 1;
+        carry.assign(chunk.data() + (carryBase - chunkBase), chunkBase + chunk.size() - carryBase);
+        return out;
+    }
+
+    std::vector<PhoneMatch> finish()
+    {
+        std::vector<PhoneMatch> out;
+        if (!finished)
+        {
+            scanCarry(true, SIZE_MAX, out);
+            finished = true;
+        }
+        return out;
+    }
+
+    void reset() noexcept
+    {
+        state = PhoneScanner::ScanState();
+        carry.clear();
+        carryBase = 0;
+        next = 0;
+        finished = false;
+    }
+
+    size_t bytesScanned() const noexcept { return next; }
+    size_t carrySize() const noexcept { return carry.size(); }
+};
+
+// ============================================================================
+// INCREMENTAL SCANNER
+// ============================================================================
+
+// Keeps the matches of a document that is edited in place and, after each
+// edit, rescans only a window around it. The results always equal
+// extractViews() of the whole document.
+//
+// The scan state at a position is known without scanning from the start in
+// two cases. After a byte that cannot be part of a number, nothing is pending.
+// At a checkpoint, the state was saved. Scans record a checkpoint every
+// CHECKPOINT_INTERVAL bytes unless the preceding byte already ends the state,
+// so one of the two always lies within that distance.
+//
+// An edit resumes from the last such point at least LOOKAHEAD bytes before
+// it. It stops at the first point after the edit where the new state equals
+// the old one. From there on the old matches are still right and only shift.
+// Matches and checkpoints live in chunks kept in a balanced tree with lazy
+// offsets, so shifting them costs O(log chunks) rather than one addition per
+// match or per chunk.
+class IncrementalPhoneScanner
+{
+public:
+    static constexpr size_t LOOKAHEAD = PhoneScanner::LOOKAHEAD;
+    static constexpr size_t CHECKPOINT_INTERVAL = 2 * LOOKAHEAD;
+
+    struct Match
+    {
+        PhoneType type;
+        size_t position;
+        size_t length;
+    };
+
+    // Matches [first, first + inserted) replaced `removed` old ones.
+    struct Update
+    {
+        size_t first = 0;
+        size_t removed = 0;
+        size_t inserted = 0;
+        size_t scannedBytes = 0;
+    };
+
+private:
+    // Pending state fields relative to position; 0 means nothing pending.
+    struct Checkpoint
+    {
+        size_t position;
+        uint8_t intl, fmt, last;
+
+        bool sameState(const Checkpoint &other) const noexcept
+        {
+            return intl == other.intl && fmt == other.fmt && last == other.last;
+        }
+    };
+
+    // Items in position order, in non-empty chunks of at most CHUNK items.
+    // The chunks are the in-order nodes of a treap whose subtrees carry item
+    // and chunk counts and a pending shift, so finding a chunk by position or
+    // rank, and shifting every chunk past a point, cost O(log chunks). An
+    // item's position is its stored position plus its chunk's base plus the
+    // pending shifts on the path from the root.
+    template <typename T>
+    class ChunkedList
+    {
+        static constexpr uint32_t NONE = ~0u;
+
+    public:
+        static constexpr size_t CHUNK = 256;
+
+        // node and offset cache the lookup of chunk; offset is added to the
+        // node's stored positions.
+        struct Cursor
+        {
+            size_t chunk, index;
+            uint32_t node = NONE;
+            size_t offset = 0;
+        };
+
+    private:
+        struct Node
+        {
+            std::vector<T> items;
+            size_t base = 0;   // own items only
+            size_t shift = 0;  // the whole subtree; not yet pushed to the children
+            size_t total = 0;  // items in the subtree
+            size_t chunks = 0; // nodes in the subtree
+            uint32_t left = NONE, right = NONE, priority = 0;
+        };
+
+        std::vector<Node> nodes;
+        std::vector<uint32_t> unused;
+        uint32_t root = NONE;
+        uint32_t seed = 0x9E3779B9u;
+
+        size_t totalOf(uint32_t x) const noexcept { return x == NONE ? 0 : nodes[x].total; }
+        size_t chunksOf(uint32_t x) const noexcept { return x == NONE ? 0 : nodes[x].chunks; }
+
+        void update(uint32_t x) noexcept
+        {
+            Node &n = nodes[x];
+            n.total = n.items.size() + totalOf(n.left) + totalOf(n.right);
+            n.chunks = 1 + chunksOf(n.left) + chunksOf(n.right);
+        }
+
+        void push(uint32_t x) noexcept
+        {
+            Node &n = nodes[x];
+            if (n.shift == 0)
+                return;
+            n.base += n.shift;
+            if (n.left != NONE)
+                nodes[n.left].shift += n.shift;
+            if (n.right != NONE)
+                nodes[n.right].shift += n.shift;
+            n.shift = 0;
+        }
+
+        uint32_t makeNode(std::vector<T> items, size_t base)
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            uint32_t x;
+            if (unused.empty())
+            {
+                x = static_cast<uint32_t>(nodes.size());
+                nodes.emplace_back();
+            }
+            else
+            {
+                x = unused.back();
+                unused.pop_back();
+                nodes[x] = Node();
+            }
+            nodes[x].items = std::move(items);
+            nodes[x].base = base;
+            nodes[x].priority = seed;
+            update(x);
+            return x;
+        }
+
+        void release(uint32_t x)
+        {
+            nodes[x].items = std::vector<T>();
+            unused.push_back(x);
+        }
+
+        uint32_t merge(uint32_t a, uint32_t b) noexcept
+        {
+            if (a == NONE)
+                return b;
+            if (b == NONE)
+                return a;
+            if (nodes[a].priority > nodes[b].priority)
+            {
+                push(a);
+                nodes[a].right = merge(nodes[a].right, b);
+                update(a);
+                return a;
+            }
+            push(b);
+            nodes[b].left = merge(a, nodes[b].left);
+            update(b);
+            return b;
+        }
+
+        // The first k chunks of x go to a, the rest to b.
+        void split(uint32_t x, size_t k, uint32_t &a, uint32_t &b) noexcept
+        {
+            if (x == NONE)
+            {
+                a = b = NONE;
+                return;
+            }
+            push(x);
+            const size_t before = chunksOf(nodes[x].left);
+            if (k <= before)
+            {
+                uint32_t left;
+                split(nodes[x].left, k, a, left);
+                nodes[x].left = left;
+                b = x;
+            }
+            else
+            {
+                uint32_t right;
+                split(nodes[x].right, k - before - 1, right, b);
+                nodes[x].right = right;
+                a = x;
+            }
+            update(x);
+        }
+
+        // Joins the last chunk of a and the first of b if both fit in one.
+        void join(uint32_t &a, uint32_t &b)
+        {
+            if (a == NONE || b == NONE)
+                return;
+            uint32_t last, first;
+            split(a, chunksOf(a) - 1, a, last);
+            split(b, 1, first, b);
+            push(last);
+            push(first);
+            if (nodes[last].items.size() + nodes[first].items.size() <= CHUNK)
+            {
+                const size_t delta = nodes[first].base - nodes[last].base; // modular
+                for (T item : nodes[first].items)
+                {
+                    item.position += delta;
+                    nodes[last].items.push_back(item);
+                }
+                update(last);
+                release(first);
+            }
+            else
+                b = merge(first, b);
+            a = merge(a, last);
+        }
+
+        Cursor locate(size_t chunk) const noexcept
+        {
+            uint32_t x = root;
+            size_t offset = 0, rank = chunk;
+            while (x != NONE)
+            {
+                const Node &n = nodes[x];
+                offset += n.shift;
+                const size_t before = chunksOf(n.left);
+                if (rank == before)
+                    return {chunk, 0, x, offset + n.base};
+                if (rank < before)
+                    x = n.left;
+                else
+                {
+                    rank -= before + 1;
+                    x = n.right;
+                }
+            }
+            return {chunksOf(root), 0};
+        }
+
+        size_t depthOf(uint32_t x) const noexcept
+        {
+            return x == NONE ? 0 : 1 + std::max(depthOf(nodes[x].left), depthOf(nodes[x].right));
+        }
+
+    public:
+        size_t size() const noexcept { return totalOf(root); }
+        size_t chunkCount() const noexcept { return chunksOf(root); }
+        // Nodes on the longest root-to-leaf path; every lookup and shift visits at most this many per step.
+        size_t depth() const noexcept { return depthOf(root); }
+
+        void clear() noexcept
+        {
+            nodes.clear();
+            unused.clear();
+            root = NONE;
+        }
+
+        void append(const T &item)
+        {
+            uint32_t x = root;
+            size_t offset = 0;
+            while (x != NONE && nodes[x].right != NONE)
+            {
+                offset += nodes[x].shift;
+                x = nodes[x].right;
+            }
+            if (x == NONE || nodes[x].items.size() == CHUNK)
+            {
+                root = merge(root, makeNode({item}, 0));
+                return;
+            }
+            T stored = item;
+            stored.position -= offset + nodes[x].shift + nodes[x].base;
+            nodes[x].items.push_back(stored);
+            for (uint32_t y = root; y != NONE; y = nodes[y].right)
+                ++nodes[y].total;
+        }
+
+        // First item at or after position p.
+        Cursor lowerBound(size_t p) const noexcept
+        {
+            Cursor found = {chunksOf(root), 0};
+            uint32_t x = root;
+            size_t offset = 0, before = 0;
+            while (x != NONE)
+            {
+                const Node &n = nodes[x];
+                offset += n.shift;
+                const size_t rank = before + chunksOf(n.left);
+                if (n.items.back().position + offset + n.base < p)
+                {
+                    before = rank + 1;
+                    x = n.right;
+                }
+                else
+                {
+                    found = {rank, 0, x, offset + n.base};
+                    x = n.left;
+                }
+            }
+            if (found.node == NONE)
+                return found;
+            const std::vector<T> &items = nodes[found.node].items;
+            size_t i = 0, j = items.size();
+            while (i < j)
+            {
+                const size_t mid = (i + j) / 2;
+                if (items[mid].position + found.offset < p)
+                    i = mid + 1;
+                else
+                    j = mid;
+            }
+            found.index = i;
+            return found;
+        }
+
+        bool atEnd(Cursor c) const noexcept { return c.node == NONE; }
+
+        void next(Cursor &c) const noexcept
+        {
+            if (++c.index == nodes[c.node].items.size())
+                c = locate(c.chunk + 1);
+        }
+
+        void prev(Cursor &c) const noexcept
+        {
+            if (c.index == 0)
+            {
+                c = locate(c.chunk - 1);
+                c.index = nodes[c.node].items.size() - 1;
+            }
+            else
+                --c.index;
+        }
+
+        T get(Cursor c) const noexcept
+        {
+            T item = nodes[c.node].items[c.index];
+            item.position += c.offset;
+            return item;
+        }
+
+        size_t indexOf(Cursor c) const noexcept
+        {
+            size_t index = c.index, rank = c.chunk;
+            uint32_t x = root;
+            while (x != NONE)
+            {
+                const Node &n = nodes[x];
+                const size_t before = chunksOf(n.left);
+                if (rank < before)
+                    x = n.left;
+                else
+                {
+                    index += totalOf(n.left);
+                    if (rank == before)
+                        break;
+                    index += n.items.size();
+                    rank -= before + 1;
+                    x = n.right;
+                }
+            }
+            return index;
+        }
+
+        T at(size_t i) const noexcept
+        {
+            uint32_t x = root;
+            size_t offset = 0;
+            for (;;)
+            {
+                const Node &n = nodes[x];
+                offset += n.shift;
+                const size_t before = totalOf(n.left);
+                if (i < before)
+                    x = n.left;
+                else if (i - before < n.items.size())
+                {
+                    T item = n.items[i - before];
+                    item.position += offset + n.base;
+                    return item;
+                }
+                else
+                {
+                    i -= before + n.items.size();
+                    x = n.right;
+                }
+            }
+        }
+
+        // Replaces the items at positions [from, to) with `replacement`, whose
+        // positions are final, and moves every item from `to` on by `shift`.
+        // The chunk holding `from` is edited in place; later chunks move by a
+        // pending shift on their subtree. Returns how many items were removed.
+        size_t splice(size_t from, size_t to, size_t shift, const std::vector<T> &replacement)
+        {
+            const Cursor c = lowerBound(from);
+            uint32_t left, rest, chunk;
+            split(root, c.chunk, left, rest);
+            split(rest, 1, chunk, rest);
+            if (chunk == NONE)
+                chunk = makeNode({}, 0);
+            push(chunk);
+
+            // Items before `to`: the tail of this chunk, then whole or leading parts of the next.
+            std::vector<T> &items = nodes[chunk].items;
+            const size_t base = nodes[chunk].base;
+            size_t end = c.index;
+            while (end < items.size() && items[end].position + base < to)
+                ++end;
+            size_t removed = end - c.index;
+            while (end == items.size() && rest != NONE)
+            {
+                uint32_t next;
+                split(rest, 1, next, rest);
+                push(next);
+                std::vector<T> &nextItems = nodes[next].items;
+                size_t n = 0;
+                while (n < nextItems.size() && nextItems[n].position + nodes[next].base < to)
+                    ++n;
+                removed += n;
+                if (n == nextItems.size())
+                {
+                    release(next);
+                    continue;
+                }
+                nextItems.erase(nextItems.begin(), nextItems.begin() + static_cast<ptrdiff_t>(n));
+                update(next);
+                rest = merge(next, rest);
+                break;
+            }
+            if (rest != NONE)
+                nodes[rest].shift += shift;
+
+            for (size_t i = end; i < items.size(); ++i)
+                items[i].position += shift;
+            items.erase(items.begin() + static_cast<ptrdiff_t>(c.index), items.begin() + static_cast<ptrdiff_t>(end));
+            items.insert(items.begin() + static_cast<ptrdiff_t>(c.index), replacement.begin(), replacement.end());
+            for (size_t i = c.index; i < c.index + replacement.size(); ++i)
+                items[i].position -= base;
+
+            if (items.size() > CHUNK)
+            {
+                // Overfull: split evenly, so that the pieces have room to grow.
+                std::vector<T> all = std::move(items);
+                release(chunk);
+                chunk = NONE;
+                const size_t pieces = all.size() / (CHUNK / 2);
+                for (size_t r = 0; r < pieces; ++r)
+                    chunk = merge(chunk, makeNode(std::vector<T>(all.begin() + static_cast<ptrdiff_t>(all.size() * r / pieces),
+                                                                 all.begin() + static_cast<ptrdiff_t>(all.size() * (r + 1) / pieces)),
+                                                  base));
+            }
+            else if (items.empty())
+            {
+                release(chunk);
+                chunk = NONE;
+            }
+            else
+                update(chunk);
+
+            // Keep chunks from fragmenting around repeated edits: a small
+            // chunk moves into the one before it if that has room.
+            if (chunk != NONE && chunksOf(chunk) == 1 && nodes[chunk].items.size() <= CHUNK / 4)
+                join(left, chunk);
+            root = merge(merge(left, chunk), rest);
+            return removed;
+        }
+    };
+
+    using ScanState = PhoneScanner::ScanState;
+
+    PhoneScanner scanner;
+    ChunkedList<Match> found;
+    ChunkedList<Checkpoint> checkpoints;
+    size_t length = 0;
+
+    static Checkpoint capture(size_t position, const ScanState &state) noexcept
+    {
+        auto ahead = [&](size_t next)
+        { return static_cast<uint8_t>(next > position ? next - position : 0); };
+        return {position, ahead(state.intlNext), ahead(state.fmtNext), ahead(state.lastEnd)};
+    }
+
+    static ScanState restore(const Checkpoint &cp) noexcept
+    {
+        return {cp.position + cp.intl, cp.position + cp.fmt, cp.position + cp.last};
+    }
+
+    // Scans from `from` with `state` until a position past resyncAfter where
+    // the state matches an old checkpoint (at `old`, shifted by `shift`), or
+    // one where nothing is pending, or to the end. Returns the stop.
+    template <typename OnMatch, typename OnCheckpoint>
+    size_t rescan(const char *data, size_t len, size_t from, ScanState state, size_t resyncAfter,
+                  typename ChunkedList<Checkpoint>::Cursor old, size_t shift, OnMatch &&onMatch,
+                  OnCheckpoint &&onCheckpoint) const
+    {
+        size_t pos = from, quietFrom = std::max(from, resyncAfter);
+        while (pos < len)
+        {
+            size_t stop = std::min(pos + CHECKPOINT_INTERVAL, len);
+            bool quiet = false, atCheckpoint = false;
+            if (stop > resyncAfter)
+            {
+                for (size_t j = std::max(quietFrom, pos) + 1; j <= stop; ++j)
+                    if (!CharacterClassifier::isPhoneChar(data[j - 1]))
+                    {
+                        stop = j;
+                        quiet = true;
+                        break;
+                    }
+                quietFrom = stop;
+                while (!checkpoints.atEnd(old) && checkpoints.get(old).position + shift <= pos)
+                    checkpoints.next(old);
+                if (!checkpoints.atEnd(old) && checkpoints.get(old).position + shift <= stop)
+                {
+                    stop = checkpoints.get(old).position + shift;
+                    quiet = false;
+                    atCheckpoint = true;
+                }
+            }
+
+            scanner.scanRange(data, len, pos, stop, state, [&](PhoneType type, size_t start, size_t end)
+                              { onMatch(Match{type, start, end - start}); });
+            pos = stop;
+            if (pos == len || quiet)
+                break;
+            const Checkpoint here = capture(pos, state);
+            if (atCheckpoint && here.sameState(checkpoints.get(old)))
+                break;
+            if (CharacterClassifier::isPhoneChar(data[pos - 1]))
+                onCheckpoint(here);
+        }
+        return pos;
+    }
+
+public:
+    IncrementalPhoneScanner() = default;
+    explicit IncrementalPhoneScanner(std::string_view text) { reset(text); }
+
+    // Scans the whole document and forgets any previous one.
+    Update reset(std::string_view text)
+    {
+        Update update;
+        update.removed = found.size();
+        found.clear();
+        checkpoints.clear();
+        length = text.size();
+        if (length <= PhoneScanner::MAX_INPUT_SIZE)
+            update.scannedBytes = rescan(text.data(), length, 0, ScanState(), SIZE_MAX, checkpoints.lowerBound(0), 0,
+                                         [&](const Match &m)
+                                         { found.append(m); },
+                                         [&](const Checkpoint &cp)
+                                         { checkpoints.append(cp); });
+        update.inserted = found.size();
+        return update;
+    }
+
+    // `text` is the document after the edit: `removed` bytes at `offset` were
+    // replaced by `inserted` bytes. An edit that does not fit the previous
+    // length rescans everything.
+    Update edit(std::string_view text, size_t offset, size_t removed, size_t inserted)
+    {
+        const size_t len = text.size();
+        if (UNLIKELY(offset > length || removed > length - offset || len != length - removed + inserted ||
+                     length > PhoneScanner::MAX_INPUT_SIZE || len > PhoneScanner::MAX_INPUT_SIZE))
+            return reset(text);
+
+        const char *data = text.data();
+        const size_t shift = inserted - removed; // modular: positions past the edit move by this
+
+        // Resume point: candidates before it read only bytes before the edit.
+        const size_t limit = offset > LOOKAHEAD ? offset - LOOKAHEAD : 0;
+        auto cp = checkpoints.lowerBound(limit + 1);
+        size_t from = 0;
+        ScanState state;
+        if (cp.chunk || cp.index)
+        {
+            auto last = cp;
+            checkpoints.prev(last);
+            from = checkpoints.get(last).position;
+            state = restore(checkpoints.get(last));
+        }
+        for (size_t j = limit; j > from; --j)
+            if (!CharacterClassifier::isPhoneChar(data[j - 1]))
+            {
+                from = j;
+                state = ScanState();
+                break;
+            }
+
+        // Only old checkpoints past the edit can confirm a resync.
+        std::vector<Match> newMatches;
+        std::vector<Checkpoint> newCheckpoints;
+        const size_t stop = rescan(data, len, from, state, offset + inserted, checkpoints.lowerBound(offset + removed + 1),
+                                   shift, [&](const Match &m)
+                                   { newMatches.push_back(m); },
+                                   [&](const Checkpoint &c)
+                                   { newCheckpoints.push_back(c); });
+        const size_t oldStop = stop - shift;
+
+        Update update;
+        update.first = found.indexOf(found.lowerBound(from));
+        update.removed = found.splice(from, oldStop, shift, newMatches);
+        update.inserted = newMatches.size();
+        update.scannedBytes = stop - from;
+        checkpoints.splice(from + 1, oldStop, shift, newCheckpoints);
+        length = len;
+        return update;
+    }
+
+    Update insert(std::string_view text, size_t offset, size_t count) { return edit(text, offset, 0, count); }
+    Update erase(std::string_view text, size_t offset, size_t count) { return edit(text, offset, count, 0); }
+
+    size_t size() const noexcept { return found.size(); }
+    Match operator[](size_t i) const noexcept { return found.at(i); }
+    size_t documentLength() const noexcept { return length; }
+    size_t checkpointCount() const noexcept { return checkpoints.size(); }
+    // Storage chunks, and the longest path a lookup or shift walks through them.
+    size_t chunkCount() const noexcept { return found.chunkCount() + checkpoints.chunkCount(); }
+    size_t chunkDepth() const noexcept { return std::max(found.depth(), checkpoints.depth()); }
+
+    // All matches in position order.
+    std::vector<Match> matches() const
+    {
+        std::vector<Match> out;
+        out.reserve(found.size());
+        for (auto c = found.lowerBound(0); !found.atEnd(c); found.next(c))
+            out.push_back(found.get(c));
+        return out;
+    }
+
+    // `text` must be the document the matches belong to.
+    static PhoneMatchView view(std::string_view text, const Match &match) noexcept
+    {
+        return {match.type, match.position, text.substr(match.position, match.length)};
+    }
+};
+
+// ============================================================================
+// CUSTOM FORMATS
+// ============================================================================
+
+// Formats registered at run time. A pattern is a sequence of elements, each
+// optionally followed by a quantifier; there is no grouping or alternation,
+// so register one pattern per layout:
+//
+//   D            any digit
+//   N            a digit 2-9 (NANP area and exchange codes)
+//   0-9 + ( )    the character itself; so are space, tab, '-' and '.'
+//   [...]        any listed character; "2-9" between two digits is a range
+//   ? {n} {m,n}  optional, exactly n times, or m to n times
+//
+// "+44 D{4} D{6}", "([1-9]DD) NDD-DDDD" and "1-800-NDD-DDDD" show literal
+// prefixes and leading-digit rules. A pattern may only start with a digit,
+// '+' or '(' and match at most MAX_LENGTH bytes, so candidates start where the
+// built-in engine's do and the lookahead stays bounded. add() returns false
+// and registers nothing if the pattern breaks these rules. Longer matches
+// win, so a pattern that may end on a separator will take it along.
+class PhoneFormatSet
+{
+public:
+    static constexpr size_t MAX_LENGTH = 30;
+    // Every byte a pattern can name, in the order of the bits of a CharSet.
+    static constexpr char PHONE_CHARS[] = "0123456789\t ()+-.";
+    static constexpr size_t PHONE_CHAR_COUNT = sizeof(PHONE_CHARS) - 1;
+
+    using CharSet = uint32_t;
+
+    struct Element
+    {
+        CharSet chars;
+        uint8_t min;
+        uint8_t max;
+    };
+
+    struct Format
+    {
+        std::string pattern;
+        PhoneType type;
+        std::vector<Element> elements;
+    };
+
+private:
+    std::vector<Format> formats;
+
+    static constexpr int charIndex(char c) noexcept
+    {
+        for (size_t k = 0; k < PHONE_CHAR_COUNT; ++k)
+            if (PHONE_CHARS[k] == c)
+                return static_cast<int>(k);
+        return -1;
+    }
+
+    static constexpr CharSet digitRange(char from, char to) noexcept
+    {
+        CharSet set = 0;
+        for (char c = from; c <= to; ++c)
+            set |= CharSet(1) << (c - '0');
+        return set;
+    }
+
+    static bool parseCount(std::string_view pattern, size_t &i, size_t &value) noexcept
+    {
+        const size_t first = i;
+        value = 0;
+        while (i < pattern.size() && CharacterClassifier::isDigit(pattern[i]) && value <= MAX_LENGTH)
+            value = value * 10 + static_cast<size_t>(pattern[i++] - '0');
+        return i > first;
+    }
+
+    static bool parse(std::string_view pattern, std::vector<Element> &elements) noexcept
+    {
+        size_t i = 0;
+        while (i < pattern.size())
+        {
+            CharSet chars = 0;
+            const char c = pattern[i++];
+            if (c == 'D')
+                chars = digitRange('0', '9');
+            else if (c == 'N')
+                chars = digitRange('2', '9');
+            else if (c == '[')
+            {
+                while (i < pattern.size() && pattern[i] != ']')
+                {
+                    const int k = charIndex(pattern[i]);
+                    if (k < 0)
+                        return false;
+                    if (i + 2 < pattern.size() && pattern[i + 1] == '-' && CharacterClassifier::isDigit(pattern[i]) &&
+                        CharacterClassifier::isDigit(pattern[i + 2]) && pattern[i] <= pattern[i + 2])
+                    {
+                        chars |= digitRange(pattern[i], pattern[i + 2]);
+                        i += 3;
+                    }
+                    else
+                    {
+                        chars |= CharSet(1) << k;
+                        ++i;
+                    }
+                }
+                if (i == pattern.size() || chars == 0)
+                    return false;
+                ++i;
+            }
+            else if (charIndex(c) >= 0)
+                chars = CharSet(1) << charIndex(c);
+            else
+                return false;
+
+            size_t min = 1, max = 1;
+            if (i < pattern.size() && pattern[i] == '?')
+            {
+                min = 0;
+                ++i;
+            }
+            else if (i < pattern.size() && pattern[i] == '{')
+            {
+                ++i;
+                if (!parseCount(pattern, i, min))
+                    return false;
+                max = min;
+                if (i < pattern.size() && pattern[i] == ',')
+                {
+                    ++i;
+                    if (!parseCount(pattern, i, max))
+                        return false;
+                }
+                if (i == pattern.size() || pattern[i] != '}' || max == 0 || min > max || max > MAX_LENGTH)
+                    return false;
+                ++i;
+            }
+            elements.push_back({chars, static_cast<uint8_t>(min), static_cast<uint8_t>(max)});
+        }
+        return true;
+    }
+
+    // The bytes a match can start with: the first element's, and the next
+    // ones' for as long as the elements before them are optional.
+    static CharSet firstChars(const std::vector<Element> &elements) noexcept
+    {
+        CharSet first = 0;
+        for (const Element &element : elements)
+        {
+            first |= element.chars;
+            if (element.min > 0)
+                break;
+        }
+        return first;
+    }
+
+public:
+    // Digits, '(' and '+': bits 0-9, 12 and 14 of PHONE_CHARS.
+    static constexpr CharSet START_CHARS = 0x3FF | CharSet(1) << 12 | CharSet(1) << 14;
+
+    bool add(std::string_view pattern, PhoneType type)
+    {
+        std::vector<Element> elements;
+        if (!parse(pattern, elements) || elements.empty())
+            return false;
+        size_t minLength = 0, maxLength = 0;
+        for (const Element &element : elements)
+        {
+            minLength += element.min;
+            maxLength += element.max;
+        }
+        if (minLength == 0 || maxLength > MAX_LENGTH || (firstChars(elements) & ~START_CHARS) != 0)
+            return false;
+        formats.push_back({std::string(pattern), type, std::move(elements)});
+        return true;
+    }
+
+    size_t size() const noexcept { return formats.size(); }
+    const Format &operator[](size_t i) const noexcept { return formats[i]; }
+
+    // The built-in formats in canonical layouts, as a starting point for
+    // adding national ones. It has no calling-code table and no per-format
+    // resume rules, so its matches can differ from PhoneScanner's on
+    // ambiguous runs of digits and separators.
+    static PhoneFormatSet builtin()
+    {
+        static const std::pair<const char *, PhoneType> patterns[] = {
+            {"([1-9]DD)[ -]NDD[ -.]?DDDD", PhoneType::FORMATTED_DOMESTIC},
+            {"[1-9]DD-NDD-DDDD", PhoneType::FORMATTED_DOMESTIC},
+            {"[1-9]DD.NDD.DDDD", PhoneType::FORMATTED_DOMESTIC},
+            {"1-[1-9]DD-DDD-DDDD", PhoneType::FORMATTED_TOLL_FREE},
+            {"1.[1-9]DD.DDD.DDDD", PhoneType::FORMATTED_TOLL_FREE},
+            {"+1[ -]?([1-9]DD)[ -]?DDD[ -]?DDDD", PhoneType::INTERNATIONAL_PLUS},
+            {"+1[ -.]?[1-9]DD[ -.]?DDD[ -.]?DDDD", PhoneType::INTERNATIONAL_PLUS},
+            {"+[2-9]D{0,2}[ -]?D{1,5}[ -]?D{3,5}", PhoneType::INTERNATIONAL_PLUS},
+            {"+[2-9]D{0,2}[ -]?D{1,5}[ -]?D{3,5}[ -]?D{3,4}", PhoneType::INTERNATIONAL_PLUS},
+            {"00[ ]?[1-9]D{0,2}[ -]?D{1,5}[ -]?D{3,5}", PhoneType::INTERNATIONAL_00},
+            {"00[ ]?[1-9]D{0,2}[ -]?D{1,5}[ -]?D{3,5}[ -]?D{3,4}", PhoneType::INTERNATIONAL_00},
+            {"[2-5]DDNDDDDDD", PhoneType::PLAIN_10_DIGIT},
+            {"1[1-9]D{9}", PhoneType::PLAIN_11_DIGIT},
+            {"[6-9]D{9}", PhoneType::MOBILE_10_DIGIT},
+            {"1D{9}", PhoneType::MOBILE_10_DIGIT},
+            {"[1-9]DDDD DDDDD", PhoneType::MOBILE_10_DIGIT},
+            {"[1-9]DD DDD DDDD", PhoneType::MOBILE_10_DIGIT},
+        };
+        PhoneFormatSet set;
+        for (const auto &[pattern, type] : patterns)
+            set.add(pattern, type);
+        return set;
+    }
+};
+
+// Runs every format of a PhoneFormatSet in one pass over the text. The
+// formats are compiled into one DFA over byte classes: the coarsest split of
+// the phone characters that the patterns can tell apart, with every other
+// byte in class 0, which leads to the dead state. Subset construction gives
+// one DFA state per set of live pattern positions, and Moore refinement
+// merges the states that accept the same type and behave alike, so a format
+// costs table space but no time per byte.
+//
+// Candidates start where the built-in engine's do (a prefiltered '+', '(' or
+// first digit of a run) and follow one table entry per byte until the dead
+// state. The longest prefix that ends before a non-digit wins, and the scan
+// resumes behind it; when formats tie, the first registered one names the
+// type. Matches are leftmost-longest and never overlap, and no candidate reads
+// more than MAX_LENGTH bytes, so the scan is linear.
+class CustomPhoneScanner
+{
+private:
+    static constexpr size_t MAX_LENGTH = PhoneFormatSet::MAX_LENGTH;
+    static constexpr size_t MAX_STATES = 65535;
+
+    uint8_t byteClass[256] = {};
+    bool startByte[256] = {};
+    size_t classCount = 1;
+    std::vector<uint16_t> next;  // next[state * classCount + class]; state 0 is dead
+    std::vector<uint8_t> accept; // 1 + PhoneType, or 0 if the state does not accept
+    uint16_t start = 0;
+
+    struct Position
+    {
+        PhoneFormatSet::CharSet chars;
+        bool optional;
+    };
+
+    using StateSet = std::vector<uint64_t>;
+
+    static bool contains(const StateSet &set, size_t k) noexcept { return (set[k / 64] >> (k % 64)) & 1; }
+    static void insert(StateSet &set, size_t k) noexcept { set[k / 64] |= uint64_t(1) << (k % 64); }
+
+    void compile(const PhoneFormatSet &formats)
+    {
+        // Byte classes: phone characters with the same membership in every
+        // element's set behave alike. Characters in no set join class 0.
+        std::map<std::vector<bool>, uint8_t> signatures;
+        uint8_t classOf[PhoneFormatSet::PHONE_CHAR_COUNT];
+        PhoneFormatSet::CharSet classChar[PhoneFormatSet::PHONE_CHAR_COUNT + 1] = {};
+        for (size_t k = 0; k < PhoneFormatSet::PHONE_CHAR_COUNT; ++k)
+        {
+            std::vector<bool> signature;
+            bool any = false;
+            for (size_t f = 0; f < formats.size(); ++f)
+                for (const auto &element : formats[f].elements)
+                {
+                    signature.push_back((element.chars >> k) & 1);
+                    any = any || signature.back();
+                }
+            if (!any)
+            {
+                classOf[k] = 0;
+                continue;
+            }
+            auto found = signatures.emplace(signature, static_cast<uint8_t>(signatures.size() + 1)).first;
+            classOf[k] = found->second;
+            classChar[found->second] = PhoneFormatSet::CharSet(1) << k;
+        }
+        classCount = signatures.size() + 1;
+        for (size_t k = 0; k < PhoneFormatSet::PHONE_CHAR_COUNT; ++k)
+            byteClass[static_cast<unsigned char>(PhoneFormatSet::PHONE_CHARS[k])] = classOf[k];
+
+        // NFA: one position per repetition of each element, plus an accepting
+        // end position per format. Epsilon moves only skip optional positions
+        // forward, so one ascending sweep closes a set.
+        std::vector<Position> positions;
+        std::vector<size_t> firsts;
+        std::vector<int> acceptAt; // 1 + PhoneType at end positions
+        for (size_t f = 0; f < formats.size(); ++f)
+        {
+            firsts.push_back(positions.size());
+            for (const auto &element : formats[f].elements)
+                for (size_t r = 0; r < element.max; ++r)
+                    positions.push_back({element.chars, r >= element.min});
+            positions.push_back({0, false});
+            acceptAt.resize(positions.size(), 0);
+            acceptAt.back() = 1 + static_cast<int>(formats[f].type);
+        }
+        const size_t words = (positions.size() + 63) / 64;
+        auto close = [&](StateSet &set)
+        {
+            for (size_t k = 0; k < positions.size(); ++k)
+                if (contains(set, k) && positions[k].optional)
+                    insert(set, k + 1);
+        };
+        auto accepts = [&](const StateSet &set)
+        {
+            for (size_t k = 0; k < positions.size(); ++k)
+                if (acceptAt[k] && contains(set, k))
+                    return static_cast<uint8_t>(acceptAt[k]);
+            return uint8_t(0);
+        };
+
+        // Subset construction, state 0 being the empty set.
+        std::vector<StateSet> sets{StateSet(words, 0)};
+        std::map<StateSet, uint16_t> ids{{sets[0], 0}};
+        StateSet initial(words, 0);
+        for (size_t first : firsts)
+            insert(initial, first);
+        close(initial);
+        sets.push_back(initial);
+        ids.emplace(initial, 1);
+        std::vector<uint16_t> table;
+        for (size_t s = 0; s < sets.size(); ++s)
+        {
+            for (size_t c = 0; c < classCount; ++c)
+            {
+                StateSet target(words, 0);
+                if (c != 0)
+                    for (size_t k = 0; k < positions.size(); ++k)
+                        if (contains(sets[s], k) && (positions[k].chars & classChar[c]))
+                            insert(target, k + 1);
+                close(target);
+                auto found = ids.find(target);
+                if (found == ids.end())
+                {
+                    if (sets.size() > MAX_STATES)
+                        return;
+                    found = ids.emplace(target, static_cast<uint16_t>(sets.size())).first;
+                    sets.push_back(target);
+                }
+                table.push_back(found->second);
+            }
+        }
+
+        // Moore refinement: split blocks until every state's block and the
+        // blocks of its successors determine each other.
+        const size_t stateCount = sets.size();
+        std::vector<size_t> block(stateCount);
+        for (size_t s = 0; s < stateCount; ++s)
+            block[s] = s == 0 ? 0 : 1 + accepts(sets[s]);
+        size_t blocks = 0;
+        for (;;)
+        {
+            std::map<std::vector<size_t>, size_t> split;
+            std::vector<size_t> refined(stateCount);
+            for (size_t s = 0; s < stateCount; ++s)
+            {
+                std::vector<size_t> key{block[s]};
+                for (size_t c = 0; c < classCount; ++c)
+                    key.push_back(block[table[s * classCount + c]]);
+                refined[s] = split.emplace(std::move(key), split.size()).first->second;
+            }
+            block.swap(refined);
+            if (split.size() == blocks)
+                break;
+            blocks = split.size();
+        }
+
+        // Renumber so the dead block is 0, then keep one row per block.
+        std::vector<int> renumber(blocks, -1);
+        renumber[block[0]] = 0;
+        uint16_t used = 1;
+        for (size_t s = 1; s < stateCount; ++s)
+            if (renumber[block[s]] < 0)
+                renumber[block[s]] = used++;
+        next.assign(size_t(used) * classCount, 0);
+        accept.assign(used, 0);
+        for (size_t s = 0; s < stateCount; ++s)
+        {
+            const size_t row = static_cast<size_t>(renumber[block[s]]);
+            accept[row] = s == 0 ? 0 : accepts(sets[s]);
+            for (size_t c = 0; c < classCount; ++c)
+                next[row * classCount + c] = static_cast<uint16_t>(renumber[block[table[s * classCount + c]]]);
+        }
+        start = static_cast<uint16_t>(renumber[block[1]]);
+        for (size_t c = 1; c < classCount; ++c)
+            if (next[size_t(start) * classCount + c] != 0)
+                for (size_t k = 0; k < PhoneFormatSet::PHONE_CHAR_COUNT; ++k)
+                    if (classOf[k] == c)
+                        startByte[static_cast<unsigned char>(PhoneFormatSet::PHONE_CHARS[k])] = true;
+    }
+
+public:
+    // Compiles the formats; they can be discarded afterwards. With no formats,
+    // or if the DFA would exceed 65535 states, nothing is compiled and every
+    // scan finds nothing.
+    explicit CustomPhoneScanner(const PhoneFormatSet &formats)
+    {
+        if (formats.size() != 0)
+            compile(formats);
+        if (next.empty())
+        {
+            next.assign(1, 0);
+            accept.assign(1, 0);
+            std::fill(std::begin(startByte), std::end(startByte), false);
+        }
+    }
+
+    size_t stateCount() const noexcept { return accept.size(); }
+    size_t byteClassCount() const noexcept { return classCount; }
+
+    // Same contract as PhoneScanner::scan(): matches in position order, and
+    // the visitor may return ScanControl::STOP. The text has no size limit.
+    template <typename Visitor>
+    bool scan(std::string_view text, Visitor &&visit) const
+    {
+        const char *data = text.data();
+        const size_t len = text.length();
+        const uint16_t *table = next.data();
+        for (size_t i = 0; i < len; ++i)
+        {
+            if (!startByte[static_cast<unsigned char>(data[i])])
+            {
+                i = CandidatePrefilter::find(data, i + 1, len);
+                if (i >= len)
+                    break;
+                if (!startByte[static_cast<unsigned char>(data[i])])
+                    continue;
+            }
+            if (i > 0 && CharacterClassifier::isDigit(data[i]) && CharacterClassifier::isDigit(data[i - 1]))
+                continue;
+
+            size_t end = 0;
+            uint8_t type = 0;
+            size_t state = start;
+            for (size_t j = i; j < len; ++j)
+            {
+                state = table[state * classCount + byteClass[static_cast<unsigned char>(data[j])]];
+                if (state == 0)
+                    break;
+                if (accept[state] && (j + 1 == len || !CharacterClassifier::isDigit(data[j + 1])))
+                {
+                    end = j + 1;
+                    type = accept[state];
+                }
+            }
+            if (end == 0)
+                continue;
+
+            const PhoneMatchView match{static_cast<PhoneType>(type - 1), i, std::string_view(data + i, end - i)};
+            if constexpr (std::is_void_v<std::invoke_result_t<Visitor &, const PhoneMatchView &>>)
+                visit(match);
+            else if (visit(match) == ScanControl::STOP)
+                return false;
+            i = end - 1;
+        }
+        return true;
+    }
+
+    size_t count(std::string_view text) const noexcept
+    {
+        CountSink sink;
+        scan(text, sink);
+        return sink.count;
+    }
+
+    std::vector<PhoneMatchView> extractViews(std::string_view text) const
+    {
+        std::vector<PhoneMatchView> matches;
+        scan(text, [&](const PhoneMatchView &match)
+             { matches.push_back(match); });
+        return matches;
+    }
+};
+
+// ============================================================================
+// RESULT CACHE
+// ============================================================================
+
+// Hit, miss and eviction counts of a CachedPhoneScanner. `bypassed` counts
+// documents over the size limit, which are scanned without the cache.
+struct PhoneCacheStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t bypassed = 0;
+
+    double hitRate() const noexcept
+    {
+        const uint64_t lookups = hits + misses;
+        return lookups == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups);
+    }
+};
+
+// Scanner front-end for traffic that repeats itself: alert texts, templated
+// notifications, email footers. A fixed number of entries map a document's
+// 64-bit hash and length to its matches, stored as (position, length, type)
+// and turned back into views over the text being scanned, so a hit does not
+// rescan. Documents over maxDocumentSize, or whose scan a visitor stops,
+// are not stored.
+//
+// Entries are split into independently locked shards, and within a shard into
+// sets of WAYS entries; a set is found from the hash and searched linearly.
+// Eviction is CLOCK per set: a hit marks the entry referenced, and the hand
+// clears marks until it finds an unmarked entry to replace. The key is only
+// the hash and the length, so two documents that collide share results; with
+// a million entries that happens about once in 2^25 distinct documents.
+template <typename Scanner>
+class BasicCachedPhoneScanner
+{
+public:
+    static constexpr size_t WAYS = 8; // one CLOCK mark per way in a byte
+    static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+    static constexpr size_t DEFAULT_MAX_DOCUMENT_SIZE = 64 * 1024;
+    static constexpr size_t DEFAULT_SHARDS = 64;
+
+private:
+    static constexpr size_t INLINE_MATCHES = 6;
+    static constexpr uint32_t EMPTY = UINT32_MAX; // length of an unused entry; no document is that long
+
+    struct CachedMatch
+    {
+        uint32_t position;
+        uint8_t length;
+        uint8_t type;
+    };
+
+    // Up to INLINE_MATCHES matches are stored in the entry, so storing the
+    // result of a short document does not allocate once the cache is warm.
+    struct Entry
+    {
+        uint32_t count = 0;
+        CachedMatch inlined[INLINE_MATCHES];
+        std::vector<CachedMatch> overflow;
+
+        const CachedMatch *matches() const noexcept { return count <= INLINE_MATCHES ? inlined : overflow.data(); }
+
+        void store(const std::vector<CachedMatch> &found)
+        {
+            count = static_cast<uint32_t>(found.size());
+            if (count <= INLINE_MATCHES)
+                std::copy(found.begin(), found.end(), inlined);
+            else
+                overflow.assign(found.begin(), found.end());
+        }
+    };
+
+    // Keys are kept apart from the matches, so a lookup reads one short run
+    // of hashes. Bit w of referenced[set] is the CLOCK mark of way w.
+    struct alignas(64) Shard
+    {
+        std::mutex mutex;
+        std::vector<uint64_t> hashes;
+        std::vector<uint32_t> lengths;
+        std::vector<Entry> entries;
+        std::vector<uint8_t> referenced;
+        std::vector<uint8_t> hands;
+        PhoneCacheStats stats;
+
+        Shard(size_t sets) : hashes(sets * WAYS, 0), lengths(sets * WAYS, EMPTY), entries(sets * WAYS), referenced(sets, 0), hands(sets, 0) {}
+
+        size_t find(size_t set, uint64_t hash, uint32_t length) const noexcept
+        {
+            for (size_t w = set; w < set + WAYS; ++w)
+                if (hashes[w] == hash && lengths[w] == length)
+                    return w;
+            return SIZE_MAX;
+        }
+    };
+
+    Scanner scanner;
+    size_t maxDocumentSize;
+    std::vector<std::unique_ptr<Shard>> shards;
+    size_t setsPerShard;
+    mutable std::atomic<uint64_t> bypassed{0};
+
+    static std::vector<CachedMatch> &scratch() noexcept
+    {
+        thread_local std::vector<CachedMatch> matches;
+        return matches;
+    }
+
+    static FORCE_INLINE uint64_t load64(const char *p) noexcept
+    {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        return word;
+    }
+
+    static FORCE_INLINE uint64_t rotl(uint64_t x, unsigned r) noexcept { return (x << r) | (x >> (64 - r)); }
+
+    Shard &shardFor(uint64_t hash) const noexcept { return *shards[hash % shards.size()]; }
+    size_t setFor(uint64_t hash) const noexcept { return static_cast<size_t>((hash >> 32) % setsPerShard) * WAYS; }
+
+    template <typename Visitor>
+    static FORCE_INLINE bool emit(Visitor &visit, const PhoneMatchView &match)
+    {
+        if constexpr (std::is_void_v<std::invoke_result_t<Visitor &, const PhoneMatchView &>>)
+        {
+            visit(match);
+            return true;
+        }
+        else
+            return visit(match) != ScanControl::STOP;
+    }
+
+public:
+    // `capacity` is the number of documents kept, rounded up to whole sets in
+    // every shard.
+    explicit BasicCachedPhoneScanner(size_t capacity = DEFAULT_CAPACITY, size_t maxDocumentBytes = DEFAULT_MAX_DOCUMENT_SIZE,
+                                     size_t shardCount = DEFAULT_SHARDS, Scanner inner = Scanner())
+        : scanner(std::move(inner)), maxDocumentSize(std::min<size_t>(maxDocumentBytes, EMPTY - 1))
+    {
+        shardCount = std::max<size_t>(1, shardCount);
+        setsPerShard = std::max<size_t>(1, (capacity + shardCount * WAYS - 1) / (shardCount * WAYS));
+        for (size_t s = 0; s < shardCount; ++s)
+            shards.push_back(std::make_unique<Shard>(setsPerShard));
+    }
+
+    // 64-bit hash of the bytes: two multiply-rotate lanes over 16-byte
+    // blocks and a splitmix64 finish. Not keyed; do not cache untrusted input
+    // where a crafted collision would matter.
+    static uint64_t hash(std::string_view text) noexcept
+    {
+        const char *p = text.data();
+        size_t n = text.size();
+        uint64_t a = 0x9E3779B97F4A7C15ull ^ n;
+        uint64_t b = 0xC2B2AE3D27D4EB4Full;
+        for (; n >= 16; p += 16, n -= 16)
+        {
+            a = rotl((a ^ load64(p)) * 0xFF51AFD7ED558CCDull, 29);
+            b = rotl((b ^ load64(p + 8)) * 0xC4CEB9FE1A85EC53ull, 31);
+        }
+        if (n != 0)
+        {
+            char tail[16] = {};
+            std::memcpy(tail, p, n);
+            a = rotl((a ^ load64(tail)) * 0xFF51AFD7ED558CCDull, 29);
+            b = rotl((b ^ load64(tail + 8)) * 0xC4CEB9FE1A85EC53ull, 31);
+        }
+        return DistinctEstimator::mix(a ^ rotl(b, 17));
+    }
+
+    // Same contract as the scanner's scan(): matches in position order, and
+    // the visitor may return ScanControl::STOP. Matches pass through a
+    // per-thread buffer, so the visitor must not scan through a cache itself.
+    template <typename Visitor>
+    bool scan(std::string_view text, Visitor &&visit) const
+    {
+        const size_t length = text.length();
+        if (length > maxDocumentSize)
+        {
+            bypassed.fetch_add(1, std::memory_order_relaxed);
+            return scanner.scan(text, visit);
+        }
+
+        const uint64_t key = hash(text);
+        const uint32_t keyLength = static_cast<uint32_t>(length);
+        Shard &shard = shardFor(key);
+        const size_t set = setFor(key);
+        std::vector<CachedMatch> &matches = scratch();
+        bool found = false;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            const size_t w = shard.find(set, key, keyLength);
+            found = w != SIZE_MAX;
+            if (found)
+            {
+                shard.referenced[set / WAYS] |= static_cast<uint8_t>(1u << (w - set));
+                const Entry &entry = shard.entries[w];
+                matches.assign(entry.matches(), entry.matches() + entry.count);
+            }
+            ++(found ? shard.stats.hits : shard.stats.misses);
+        }
+
+        if (found)
+        {
+            // Emitted outside the lock, from this thread's copy.
+            const char *data = text.data();
+            for (const CachedMatch &m : matches)
+                if (!emit(visit, {static_cast<PhoneType>(m.type), m.position, std::string_view(data + m.position, m.length)}))
+                    return false;
+            return true;
+        }
+
+        // Miss: scan, keeping what the visitor sees, and store the result
+        // unless the visitor stopped early.
+        matches.clear();
+        const bool complete = scanner.scan(text, [&](const PhoneMatchView &match)
+                                           {
+            matches.push_back({static_cast<uint32_t>(match.position), static_cast<uint8_t>(match.value.size()),
+                               static_cast<uint8_t>(match.type)});
+            return emit(visit, match) ? ScanControl::CONTINUE : ScanControl::STOP; });
+        if (!complete)
+            return false;
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.find(set, key, keyLength) != SIZE_MAX)
+            return true; // another thread stored it meanwhile
+        uint8_t &marks = shard.referenced[set / WAYS];
+        uint8_t &hand = shard.hands[set / WAYS];
+        while (marks & (1u << hand))
+        {
+            marks = static_cast<uint8_t>(marks & ~(1u << hand));
+            hand = static_cast<uint8_t>((hand + 1) % WAYS);
+        }
+        const size_t victim = set + hand;
+        hand = static_cast<uint8_t>((hand + 1) % WAYS);
+        shard.stats.evictions += shard.lengths[victim] != EMPTY;
+        shard.hashes[victim] = key;
+        shard.lengths[victim] = keyLength;
+        shard.entries[victim].store(matches);
+        return true;
+    }
+
+    std::vector<PhoneMatchView> extractViews(std::string_view text) const
+    {
+        std::vector<PhoneMatchView> matches;
+        scan(text, [&](const PhoneMatchView &match)
+             { matches.push_back(match); });
+        return matches;
+    }
+
+    std::vector<PhoneMatch> extract(std::string_view text) const
+    {
+        std::vector<PhoneMatch> matches;
+        scan(text, [&](const PhoneMatchView &match)
+             { matches.push_back(toPhoneMatch(match)); });
+        return matches;
+    }
+
+    size_t count(std::string_view text) const
+    {
+        CountSink sink;
+        scan(text, sink);
+        return sink.count;
+    }
+
+    PhoneCacheStats stats() const
+    {
+        PhoneCacheStats total;
+        for (const auto &shard : shards)
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            total.hits += shard->stats.hits;
+            total.misses += shard->stats.misses;
+            total.evictions += shard->stats.evictions;
+        }
+        total.bypassed = bypassed.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    // Documents currently stored.
+    size_t size() const
+    {
+        size_t stored = 0;
+        for (const auto &shard : shards)
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            for (uint32_t length : shard->lengths)
+                stored += length != EMPTY;
+        }
+        return stored;
+    }
+
+    size_t capacity() const noexcept { return shards.size() * setsPerShard * WAYS; }
+
+    // Drops every entry; the counters keep running.
+    void clear()
+    {
+        for (const auto &shard : shards)
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            std::fill(shard->lengths.begin(), shard->lengths.end(), EMPTY);
+            std::fill(shard->referenced.begin(), shard->referenced.end(), uint8_t(0));
+            for (Entry &entry : shard->entries)
+                entry.overflow = std::vector<CachedMatch>();
+        }
+    }
+
+    const Scanner &underlying() const noexcept { return scanner; }
+};
+
+using CachedPhoneScanner = BasicCachedPhoneScanner<PhoneScanner>;
+
+// ============================================================================
+// FACTORY
+// ============================================================================
+
+class PhoneDetectorFactory
+{
+public:
+    static std::unique_ptr<IPhoneValidator> createFormattedDomesticValidator()
+    {
+        return std::make_unique<FormattedDomesticValidator>();
+    }
+    static std::unique_ptr<IPhoneValidator> createInternationalValidator()
+    {
+        return std::make_unique<InternationalPlusValidator>();
+    }
+    static std::unique_ptr<IPhoneValidator> createPlainDigitValidator(size_t len, PhoneType type)
+    {
+        return std::make_unique<PlainDigitValidator>(len, type);
+    }
+    static std::unique_ptr<IPhoneValidator> createMobileValidator()
+    {
+        return std::make_unique<MobileDigitValidator>();
+    }
+    static std::unique_ptr<PhoneScanner> createScanner()
+    {
+        return std::make_unique<PhoneScanner>();
+    }
+    static std::unique_ptr<StreamingPhoneScanner> createStreamingScanner()
+    {
+        return std::make_unique<StreamingPhoneScanner>();
+    }
+};
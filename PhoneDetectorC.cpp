@@ -0,0 +1,93 @@
+#define PHONE_DETECTOR_C_BUILD 1
+#include "PhoneDetectorC.h"
+#include "PhoneDetector.hpp"
+
+#include <new>
+
+// ============================================================================
+// PhoneDetectorC - C API over PhoneScanner, built as a shared library
+//
+// Nothing here throws or allocates after phone_scanner_create(): matches go
+// straight from the scan visitor into the caller's array.
+// ============================================================================
+
+static_assert(static_cast<int>(PhoneType::FORMATTED_DOMESTIC) == PHONE_FORMATTED_DOMESTIC &&
+                  static_cast<int>(PhoneType::FORMATTED_TOLL_FREE) == PHONE_FORMATTED_TOLL_FREE &&
+                  static_cast<int>(PhoneType::INTERNATIONAL_PLUS) == PHONE_INTERNATIONAL_PLUS &&
+                  static_cast<int>(PhoneType::INTERNATIONAL_00) == PHONE_INTERNATIONAL_00 &&
+                  static_cast<int>(PhoneType::PLAIN_10_DIGIT) == PHONE_PLAIN_10_DIGIT &&
+                  static_cast<int>(PhoneType::PLAIN_11_DIGIT) == PHONE_PLAIN_11_DIGIT &&
+                  static_cast<int>(PhoneType::MOBILE_10_DIGIT) == PHONE_MOBILE_10_DIGIT,
+              "enum phone_type must mirror PhoneType");
+static_assert(sizeof(phone_match) == 16, "phone_match is part of the ABI");
+
+struct phone_scanner
+{
+    PhoneScanner scanner;
+};
+
+extern "C"
+{
+
+uint32_t phone_api_version(void)
+{
+    return PHONE_API_VERSION;
+}
+
+phone_scanner *phone_scanner_create(void)
+{
+    return new (std::nothrow) phone_scanner();
+}
+
+void phone_scanner_destroy(phone_scanner *scanner)
+{
+    delete scanner;
+}
+
+int phone_scan_batch(const phone_scanner *scanner, const phone_document *documents, size_t document_count,
+                     phone_match *matches, size_t capacity, size_t *match_count, size_t *documents_scanned)
+{
+    size_t written = 0, done = 0;
+    int status = PHONE_OK;
+    if (!scanner || (!documents && document_count != 0) || (!matches && capacity != 0))
+        status = PHONE_INVALID_ARGUMENT;
+
+    for (; status == PHONE_OK && done < document_count; ++done)
+    {
+        const size_t first = written;
+        const uint32_t document = static_cast<uint32_t>(done);
+        const bool complete = scanner->scanner.scan(std::string_view(documents[done].data, documents[done].length),
+                                                    [&](const PhoneMatchView &match)
+                                                    {
+            if (written == capacity)
+                return ScanControl::STOP;
+            matches[written++] = {document, static_cast<uint32_t>(match.position), static_cast<uint32_t>(match.value.size()),
+                                  static_cast<uint32_t>(match.type)};
+            return ScanControl::CONTINUE; });
+        if (!complete)
+        {
+            written = first; // all of a document's matches or none
+            status = PHONE_BUFFER_FULL;
+            break;
+        }
+    }
+
+    if (match_count)
+        *match_count = written;
+    if (documents_scanned)
+        *documents_scanned = done;
+    return status;
+}
+
+size_t phone_max_matches(size_t length)
+{
+    // Matches do not overlap and hold at least 7 digits each.
+    return length / 7;
+}
+
+const char *phone_type_name(uint32_t type)
+{
+    return type < static_cast<uint32_t>(PhoneType::UNKNOWN) ? phoneTypeToString(static_cast<PhoneType>(type)) : "UNKNOWN";
+}
+
+}
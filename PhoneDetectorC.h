@@ -0,0 +1,106 @@
+#ifndef PHONE_DETECTOR_C_H
+#define PHONE_DETECTOR_C_H
+
+/*
+ * PhoneDetectorC - stable C API for calling the detector from other languages
+ *
+ * One call scans a whole batch of documents into flat arrays owned by the
+ * caller, so nothing is allocated across the boundary and the per-call cost
+ * is shared by every document in the batch. A scanner handle is immutable
+ * after creation and may be used from any number of threads at once.
+ *
+ * Built as a shared library from PhoneDetectorC.cpp; see README.md.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(PHONE_DETECTOR_C_BUILD)
+#define PHONE_DETECTOR_C_API __declspec(dllexport)
+#else
+#define PHONE_DETECTOR_C_API __declspec(dllimport)
+#endif
+#elif defined(__GNUC__) || defined(__clang__)
+#define PHONE_DETECTOR_C_API __attribute__((visibility("default")))
+#else
+#define PHONE_DETECTOR_C_API
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Bumped on any incompatible change; compare with phone_api_version(). */
+#define PHONE_API_VERSION 1
+
+/* Same values as PhoneType. */
+enum phone_type
+{
+    PHONE_FORMATTED_DOMESTIC = 0,
+    PHONE_FORMATTED_TOLL_FREE = 1,
+    PHONE_INTERNATIONAL_PLUS = 2,
+    PHONE_INTERNATIONAL_00 = 3,
+    PHONE_PLAIN_10_DIGIT = 4,
+    PHONE_PLAIN_11_DIGIT = 5,
+    PHONE_MOBILE_10_DIGIT = 6
+};
+
+enum phone_status
+{
+    PHONE_OK = 0,               /* every document was scanned */
+    PHONE_BUFFER_FULL = 1,      /* stopped before a document whose matches did not fit */
+    PHONE_INVALID_ARGUMENT = 2  /* a required pointer was NULL */
+};
+
+typedef struct phone_scanner phone_scanner;
+
+/* A document: `length` bytes at `data`, not necessarily NUL-terminated. */
+typedef struct phone_document
+{
+    const char *data;
+    size_t length;
+} phone_document;
+
+/* A match: bytes [offset, offset + length) of documents[document]. */
+typedef struct phone_match
+{
+    uint32_t document;
+    uint32_t offset;
+    uint32_t length;
+    uint32_t type; /* enum phone_type */
+} phone_match;
+
+PHONE_DETECTOR_C_API uint32_t phone_api_version(void);
+
+/* Returns NULL if out of memory. */
+PHONE_DETECTOR_C_API phone_scanner *phone_scanner_create(void);
+PHONE_DETECTOR_C_API void phone_scanner_destroy(phone_scanner *scanner);
+
+/*
+ * Scans documents[0, document_count) in order and writes their matches to
+ * matches[0, capacity), in document and then position order. A document's
+ * matches are written all or not at all: if they do not fit, the call stops
+ * before that document and returns PHONE_BUFFER_FULL. *documents_scanned is
+ * then the number of documents done, so the caller can drain the buffer and
+ * call again from documents + *documents_scanned (document indices restart
+ * at 0). A capacity of phone_max_matches(length) for the largest document
+ * guarantees progress. *match_count receives the number of matches written.
+ * Documents over 10 MB have no matches.
+ */
+PHONE_DETECTOR_C_API int phone_scan_batch(const phone_scanner *scanner, const phone_document *documents,
+                                          size_t document_count, phone_match *matches, size_t capacity,
+                                          size_t *match_count, size_t *documents_scanned);
+
+/* Upper bound on the matches one document of `length` bytes can have. */
+PHONE_DETECTOR_C_API size_t phone_max_matches(size_t length);
+
+/* "FORMATTED_DOMESTIC", ..., or "UNKNOWN"; never NULL. */
+PHONE_DETECTOR_C_API const char *phone_type_name(uint32_t type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,651 @@
+#include "PhoneDetector.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ============================================================================
+// PhoneScan - command-line scanner for files and directories
+//
+//   PhoneScan [--format ndjson|tsv] [--threads N] [--read] [--quiet] PATH...
+//   PhoneScan [--format ndjson|tsv] [--threads N] [--batch SIZE] [--queue N] -
+//
+// Files are memory-mapped and scanned in place, one file per worker at a time,
+// largest files first. Matches are written to stdout, statistics to stderr.
+//
+// With "-", newline-delimited records are read from stdin by a pipeline: a
+// reader cuts blocks of whole records, workers scan them, and a writer prints
+// the results in input order. Matches are reported by line and offset within it.
+// ============================================================================
+
+namespace fs = std::filesystem;
+
+enum class OutputFormat
+{
+    NDJSON,
+    TSV
+};
+
+struct Options
+{
+    OutputFormat format = OutputFormat::NDJSON;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    bool useRead = false; // read() into a std::string instead of mmap, for comparison
+    bool quiet = false;
+    bool useStdin = false;
+    size_t batchBytes = 1024 * 1024; // records per block, by size
+    size_t queueDepth = 0;           // blocks in flight; 0 = 4 per worker
+    std::vector<std::string> paths;
+};
+
+struct InputFile
+{
+    std::string path;
+    size_t size;
+};
+
+// ============================================================================
+// INPUT
+// ============================================================================
+
+// Read-only view of a whole file, mapped with a sequential access hint.
+class MappedFile
+{
+private:
+    const char *data = nullptr;
+    size_t length = 0;
+    bool advised = false;
+
+public:
+    explicit MappedFile(const std::string &path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void *map = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map != MAP_FAILED)
+            {
+                // Advice values are not flags, so each hint is its own call.
+                const size_t size = static_cast<size_t>(st.st_size);
+                const bool sequential = ::madvise(map, size, MADV_SEQUENTIAL) == 0;
+                const bool willNeed = ::madvise(map, size, MADV_WILLNEED) == 0;
+                advised = sequential && willNeed;
+                data = static_cast<const char *>(map);
+                length = static_cast<size_t>(st.st_size);
+            }
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile()
+    {
+        if (data)
+            ::munmap(const_cast<char *>(data), length);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool valid() const noexcept { return data != nullptr; }
+    bool hinted() const noexcept { return advised; } // both access hints were accepted
+    std::string_view view() const noexcept { return std::string_view(data, length); }
+};
+
+bool readWholeFile(const std::string &path, size_t sizeHint, std::string &out)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    out.clear();
+    out.reserve(sizeHint);
+    char buffer[1 << 16];
+    ssize_t n;
+    while ((n = ::read(fd, buffer, sizeof(buffer))) > 0)
+        out.append(buffer, static_cast<size_t>(n));
+    ::close(fd);
+    return n == 0;
+}
+
+void collectFiles(const std::string &path, std::vector<InputFile> &files)
+{
+    std::error_code ec;
+    if (fs::is_directory(path, ec))
+    {
+        for (auto it = fs::recursive_directory_iterator(path, fs::directory_options::skip_permission_denied, ec);
+             it != fs::recursive_directory_iterator(); it.increment(ec))
+        {
+            if (ec)
+                break;
+            if (it->is_regular_file(ec))
+                files.push_back({it->path().string(), static_cast<size_t>(it->file_size(ec))});
+        }
+    }
+    else if (fs::is_regular_file(path, ec))
+        files.push_back({path, static_cast<size_t>(fs::file_size(path, ec))});
+    else
+        std::cerr << "PhoneScan: skipping " << path << " (not a file or directory)\n";
+}
+
+// ============================================================================
+// OUTPUT
+// ============================================================================
+
+void appendJsonString(std::string &out, std::string_view text)
+{
+    static const char hex[] = "0123456789abcdef";
+    out += '"';
+    for (unsigned char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += static_cast<char>(c);
+        }
+        else if (c < 0x20)
+        {
+            out += "\\u00";
+            out += hex[c >> 4];
+            out += hex[c & 0xF];
+        }
+        else
+            out += static_cast<char>(c);
+    }
+    out += '"';
+}
+
+void appendMatch(std::string &out, OutputFormat format, const std::string &file, const PhoneMatch &match)
+{
+    if (format == OutputFormat::TSV)
+    {
+        out += file;
+        out += '\t';
+        out += std::to_string(match.position);
+        out += '\t';
+        out += phoneTypeToString(match.type);
+        out += '\t';
+        out += match.normalized;
+        out += '\n';
+        return;
+    }
+
+    out += "{\"file\":";
+    appendJsonString(out, file);
+    out += ",\"offset\":";
+    out += std::to_string(match.position);
+    out += ",\"type\":\"";
+    out += phoneTypeToString(match.type);
+    out += "\",\"normalized\":\"";
+    out += match.normalized;
+    out += "\"}\n";
+}
+
+void appendRecordMatch(std::string &out, OutputFormat format, uint64_t line, size_t offset, PhoneType type,
+                       std::string_view normalized)
+{
+    if (format == OutputFormat::TSV)
+    {
+        out += std::to_string(line);
+        out += '\t';
+        out += std::to_string(offset);
+        out += '\t';
+        out += phoneTypeToString(type);
+        out += '\t';
+        out += normalized;
+        out += '\n';
+        return;
+    }
+
+    out += "{\"line\":";
+    out += std::to_string(line);
+    out += ",\"offset\":";
+    out += std::to_string(offset);
+    out += ",\"type\":\"";
+    out += phoneTypeToString(type);
+    out += "\",\"normalized\":\"";
+    out += normalized;
+    out += "\"}\n";
+}
+
+// Serializes whole output blocks so lines from different workers never interleave.
+class OutputSink
+{
+private:
+    std::mutex mutex;
+
+public:
+    void write(const std::string &block)
+    {
+        if (block.empty())
+            return;
+        std::lock_guard<std::mutex> lock(mutex);
+        std::fwrite(block.data(), 1, block.size(), stdout);
+    }
+};
+
+// ============================================================================
+// SCANNING
+// ============================================================================
+
+struct ScanTotals
+{
+    std::atomic<uint64_t> files{0};
+    std::atomic<uint64_t> records{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> unhinted{0}; // mapped, but madvise() refused a hint
+    std::atomic<uint64_t> split{0};    // stdin records longer than the scanner's input limit
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> matches{0};
+};
+
+// Streams one file through the scanner in slices, flushing output after each
+// slice so memory stays bounded for very large files.
+void scanBuffer(std::string_view data, const std::string &path, const Options &options,
+                OutputSink &sink, ScanTotals &totals)
+{
+    static constexpr size_t SLICE_SIZE = 4 * 1024 * 1024;
+
+    StreamingPhoneScanner stream;
+    std::string out;
+    uint64_t found = 0;
+
+    auto emit = [&](const std::vector<PhoneMatch> &matches)
+    {
+        for (const auto &match : matches)
+            appendMatch(out, options.format, path, match);
+        found += matches.size();
+        sink.write(out);
+        out.clear();
+    };
+
+    for (size_t offset = 0; offset < data.size(); offset += SLICE_SIZE)
+        emit(stream.feed(data.substr(offset, SLICE_SIZE)));
+    emit(stream.finish());
+
+    totals.bytes += data.size();
+    totals.matches += found;
+}
+
+void scanFile(const InputFile &file, const Options &options, OutputSink &sink, ScanTotals &totals)
+{
+    ++totals.files;
+    if (file.size == 0)
+        return;
+
+    if (options.useRead)
+    {
+        std::string contents;
+        if (!readWholeFile(file.path, file.size, contents))
+        {
+            ++totals.failed;
+            return;
+        }
+        scanBuffer(contents, file.path, options, sink, totals);
+        return;
+    }
+
+    MappedFile mapped(file.path);
+    if (!mapped.valid())
+    {
+        ++totals.failed;
+        return;
+    }
+    if (!mapped.hinted())
+        ++totals.unhinted;
+    scanBuffer(mapped.view(), file.path, options, sink, totals);
+}
+
+// ============================================================================
+// STDIN PIPELINE
+// ============================================================================
+
+// Whole records cut from stdin, and the output they produced. Blocks are
+// recycled through a free list, so the number of blocks bounds memory and the
+// reader stalls when the workers or the writer fall behind.
+struct RecordBlock
+{
+    std::string data;
+    size_t length = 0;
+    uint64_t sequence = 0;
+    uint64_t firstLine = 0; // 1-based line number of data[0]
+    size_t firstOffset = 0; // byte offset of data[0] within its line
+    uint64_t lines = 0;     // complete and trailing records
+    uint64_t matches = 0;
+    std::string out;
+};
+
+// A newline ends every match, so a block is scanned in one call and each
+// match is mapped back to its record by a forward newline search.
+void scanRecords(const PhoneScanner &scanner, RecordBlock &block, OutputFormat format)
+{
+    const char *data = block.data.data();
+    uint64_t line = block.firstLine;
+    size_t lineStart = 0, lineOffset = block.firstOffset, cursor = 0;
+    block.out.clear();
+    block.matches = 0;
+
+    auto emit = [&](size_t position, PhoneType type, std::string_view normalized)
+    {
+        while (const void *newline = std::memchr(data + cursor, '\n', position - cursor))
+        {
+            cursor = static_cast<size_t>(static_cast<const char *>(newline) - data) + 1;
+            lineStart = cursor;
+            lineOffset = 0;
+            ++line;
+        }
+        cursor = position;
+        appendRecordMatch(block.out, format, line, lineOffset + position - lineStart, type, normalized);
+        ++block.matches;
+    };
+
+    const std::string_view text(data, block.length);
+    if (text.size() <= PhoneScanner::maxInputSize())
+    {
+        scanner.scan(text, [&](const PhoneMatchView &match)
+                     { emit(match.position, match.type, match.normalized().view()); });
+        return;
+    }
+
+    // A single record longer than the one-shot limit.
+    StreamingPhoneScanner stream;
+    for (const auto &match : stream.feed(text))
+        emit(match.position, match.type, match.normalized);
+    for (const auto &match : stream.finish())
+        emit(match.position, match.type, match.normalized);
+}
+
+// Reads until the block is full, or until stdin has nothing more ready, so a
+// slow producer is not held back waiting for a full block.
+size_t fillBlock(int fd, RecordBlock &block, bool &eof)
+{
+    size_t added = 0;
+    while (block.length < block.data.size())
+    {
+        const ssize_t n = ::read(fd, &block.data[block.length], block.data.size() - block.length);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+        {
+            eof = true;
+            break;
+        }
+        block.length += static_cast<size_t>(n);
+        added += static_cast<size_t>(n);
+
+        pollfd ready{fd, POLLIN, 0};
+        if (::poll(&ready, 1, 0) == 0)
+            break;
+    }
+    return added;
+}
+
+void scanStdin(const Options &options, ScanTotals &totals)
+{
+    const size_t workers = std::max<size_t>(1, options.threads);
+    const size_t depth = std::max<size_t>(2, options.queueDepth ? options.queueDepth : 4 * workers);
+    const PhoneScanner scanner;
+
+    std::vector<std::unique_ptr<RecordBlock>> storage;
+    BoundedQueue<RecordBlock *> freeBlocks(depth), scanQueue(depth), writeQueue(depth + workers);
+    for (size_t b = 0; b < depth; ++b)
+    {
+        storage.push_back(std::make_unique<RecordBlock>());
+        storage.back()->data.resize(options.batchBytes);
+        freeBlocks.push(storage.back().get());
+    }
+
+    std::vector<std::thread> scanners;
+    for (size_t w = 0; w < workers; ++w)
+        scanners.emplace_back([&]()
+                              {
+            for (RecordBlock *block; (block = scanQueue.pop()) != nullptr;)
+            {
+                scanRecords(scanner, *block, options.format);
+                writeQueue.push(std::move(block));
+            }
+            writeQueue.push(nullptr); });
+
+    // Blocks finish out of order; each waits in its sequence slot until the
+    // ones before it are written. At most depth blocks exist, so depth slots do.
+    std::thread writer([&]()
+                       {
+        std::vector<RecordBlock *> pending(depth, nullptr);
+        uint64_t next = 0;
+        for (size_t finished = 0; finished < workers;)
+        {
+            RecordBlock *block = writeQueue.pop();
+            if (!block)
+            {
+                ++finished;
+                continue;
+            }
+            pending[block->sequence % depth] = block;
+            while (RecordBlock *ready = pending[next % depth])
+            {
+                pending[next % depth] = nullptr;
+                std::fwrite(ready->out.data(), 1, ready->out.size(), stdout);
+                totals.matches += ready->matches;
+                ready->length = 0;
+                freeBlocks.push(std::move(ready));
+                ++next;
+            }
+        } });
+
+    uint64_t sequence = 0, line = 1;
+    bool eof = false;
+    RecordBlock *block = freeBlocks.pop();
+    while (!eof || block->length)
+    {
+        totals.bytes += fillBlock(STDIN_FILENO, *block, eof);
+
+        size_t cut = block->length;
+        bool split = false;
+        if (!eof)
+        {
+            while (cut && block->data[cut - 1] != '\n')
+                --cut;
+            if (cut == 0 && block->length < block->data.size())
+                continue;
+            if (cut == 0 && block->data.size() < PhoneScanner::maxInputSize())
+            {
+                // No complete record yet: grow the full block and keep reading.
+                block->data.resize(std::min(block->data.size() * 2, PhoneScanner::maxInputSize()));
+                continue;
+            }
+            if (cut == 0)
+            {
+                // A record longer than the scanner's input limit is handed over in
+                // pieces, each cut after a byte no match contains, so no match
+                // is split unless the piece has no such byte.
+                cut = block->length;
+                while (cut && CharacterClassifier::isPhoneChar(block->data[cut - 1]))
+                    --cut;
+                if (cut == 0)
+                    cut = block->length;
+                split = true;
+            }
+        }
+        if (cut == 0)
+            break;
+
+        // Move the partial record after the cut to the front of the next block.
+        RecordBlock *next = freeBlocks.pop();
+        const size_t tail = block->length - cut;
+        if (next->data.size() < std::max(options.batchBytes, tail))
+            next->data.resize(std::max({options.batchBytes, tail, std::min(tail * 2, PhoneScanner::maxInputSize())}));
+        std::memcpy(&next->data[0], block->data.data() + cut, tail);
+        next->length = tail;
+        next->firstOffset = split ? block->firstOffset + cut : 0;
+        if (split && block->firstOffset == 0)
+            ++totals.split;
+
+        block->length = cut;
+        block->sequence = sequence++;
+        block->firstLine = line;
+        block->lines = static_cast<uint64_t>(std::count(block->data.data(), block->data.data() + cut, '\n'));
+        if (block->data[cut - 1] != '\n' && !split)
+            ++block->lines;
+        line += block->lines;
+        totals.records += block->lines;
+        scanQueue.push(std::move(block));
+        block = next;
+    }
+
+    for (size_t w = 0; w < workers; ++w)
+        scanQueue.push(nullptr);
+    for (auto &thread : scanners)
+        thread.join();
+    writer.join();
+    std::fflush(stdout);
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+void printUsage()
+{
+    std::cerr << "Usage: PhoneScan [options] PATH...\n"
+              << "  --format ndjson|tsv   output format (default: ndjson)\n"
+              << "  --threads N           worker threads (default: hardware threads)\n"
+              << "  --read                read() files into memory instead of mmap\n"
+              << "  --quiet               do not print statistics to stderr\n"
+              << "  -                     read newline-delimited records from stdin instead of files\n"
+              << "  --batch SIZE          stdin bytes per block handed to a worker (default: 1M; K and M suffixes)\n"
+              << "  --queue N             stdin blocks in flight (default: 4 per thread)\n";
+}
+
+bool parseOptions(int argc, char **argv, Options &options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc)
+        {
+            std::string value = argv[++i];
+            if (value == "ndjson")
+                options.format = OutputFormat::NDJSON;
+            else if (value == "tsv")
+                options.format = OutputFormat::TSV;
+            else
+                return false;
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            long threads = std::strtol(argv[++i], nullptr, 10);
+            if (threads < 1)
+                return false;
+            options.threads = static_cast<size_t>(threads);
+        }
+        else if (arg == "--read")
+            options.useRead = true;
+        else if (arg == "--quiet")
+            options.quiet = true;
+        else if (arg == "--batch" && i + 1 < argc)
+        {
+            char *end = nullptr;
+            unsigned long long bytes = std::strtoull(argv[++i], &end, 10);
+            if (*end == 'K' || *end == 'k')
+                bytes <<= 10;
+            else if (*end == 'M' || *end == 'm')
+                bytes <<= 20;
+            if (bytes < 64 || bytes > PhoneScanner::maxInputSize())
+                return false;
+            options.batchBytes = static_cast<size_t>(bytes);
+        }
+        else if (arg == "--queue" && i + 1 < argc)
+        {
+            long depth = std::strtol(argv[++i], nullptr, 10);
+            if (depth < 2)
+                return false;
+            options.queueDepth = static_cast<size_t>(depth);
+        }
+        else if (arg == "-")
+            options.useStdin = true;
+        else if (arg == "--help" || arg == "-h")
+            return false;
+        else if (!arg.empty() && arg[0] == '-')
+            return false;
+        else
+            options.paths.push_back(arg);
+    }
+    return options.useStdin != !options.paths.empty();
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (options.useStdin)
+    {
+        ScanTotals totals;
+        auto start = std::chrono::steady_clock::now();
+        scanStdin(options, totals);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (!options.quiet)
+        {
+            std::cerr << "Records: " << totals.records.load();
+            if (totals.split.load())
+                std::cerr << " (" << totals.split.load() << " over " << PhoneScanner::maxInputSize() / (1024 * 1024)
+                          << " MB, scanned in pieces)";
+            std::cerr << "\n"
+                      << "Bytes: " << totals.bytes.load() << "\n"
+                      << "Matches: " << totals.matches.load() << "\n"
+                      << "Time: " << (seconds * 1000) << " ms\n"
+                      << "Throughput: " << (totals.bytes.load() / std::max(seconds, 1e-9) / (1024.0 * 1024.0)) << " MB/s\n";
+            if (ScanStats::ENABLED)
+                std::cerr << phoneScanStats().toText();
+        }
+        return 0;
+    }
+
+    std::vector<InputFile> files;
+    for (const auto &path : options.paths)
+        collectFiles(path, files);
+
+    // Largest files first keeps the workers evenly loaded towards the end.
+    std::sort(files.begin(), files.end(), [](const InputFile &a, const InputFile &b)
+              { return a.size > b.size; });
+
+    OutputSink sink;
+    ScanTotals totals;
+    auto start = std::chrono::steady_clock::now();
+
+    ScanThreadPool pool(options.threads);
+    pool.run(files.size(), [&](size_t i)
+             { scanFile(files[i], options, sink, totals); });
+    std::fflush(stdout);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!options.quiet)
+    {
+        std::cerr << "Files: " << totals.files.load() << " (" << totals.failed.load() << " unreadable";
+        if (totals.unhinted.load())
+            std::cerr << ", " << totals.unhinted.load() << " without access hints";
+        std::cerr << ")\n"
+                  << "Bytes: " << totals.bytes.load() << "\n"
+                  << "Matches: " << totals.matches.load() << "\n"
+                  << "Time: " << (seconds * 1000) << " ms\n"
+                  << "Throughput: " << (totals.bytes.load() / std::max(seconds, 1e-9) / (1024.0 * 1024.0)) << " MB/s\n";
+        if (ScanStats::ENABLED)
+            std::cerr << phoneScanStats().toText();
+    }
+    return totals.failed.load() ? 2 : 0;
+}